@@ -0,0 +1,41 @@
+#pragma once
+
+#include "kernels/view.hpp"
+
+#include <span>
+
+// Reduction, stencil and GEMM kernels of tasks 2-4 operating directly on
+// caller memory. Nothing is allocated or copied per call; all kernels are
+// parallelised with OpenMP over the calling thread's team. Shape mismatches
+// throw std::invalid_argument. Contiguous operands whose size is in the
+// fixed-size table (src/fixed.hpp) run a compile-time specialised variant.
+namespace kernels {
+
+// ====Reduction (task-2)====
+
+long long reduceSum(std::span<const int> data);
+long long reduceSum(VectorView<const int> data);
+double reduceSum(std::span<const double> data);
+double reduceSum(VectorView<const double> data);
+
+// Bit-identical result for any thread count (see reprosum.hpp); about two
+// passes over the data instead of one.
+double reduceSumReproducible(std::span<const double> data);
+float reduceSumReproducible(std::span<const float> data);
+
+// ====Stencil (task-3)====
+
+// Central-difference d/dx along each row, one-sided at the first and last
+// column. input and output must have the same shape and at least 2 columns.
+void derivativeX(MatrixView<const double> input, MatrixView<double> output, double dx);
+void derivativeX(MatrixView<const float> input, MatrixView<float> output, float dx);
+
+// ====GEMM (task-4)====
+
+// C = A * B. Row-major and column-major operands take a cache-friendly path;
+// other strides use a generic loop. C must not overlap A or B.
+void gemm(MatrixView<const double> A, MatrixView<const double> B, MatrixView<double> C);
+void gemm(MatrixView<const float> A, MatrixView<const float> B, MatrixView<float> C);
+void gemm(MatrixView<const int> A, MatrixView<const int> B, MatrixView<int> C);
+
+}  // namespace kernels
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <CL/cl.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// NUMA partitioning of the OpenCL CPU device for the --numa mode of the task
+// 2-4 OpenCL programs. create() splits the CPU device with
+// clCreateSubDevices(CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, NUMA) into one
+// sub-device per NUMA node, creates one context over all of them and one queue
+// per sub-device. The programs split their NDRange into contiguous ranges, one
+// per sub-device (range()), and give every partition its own buffers created
+// with localBuffer(), which first touches them from the partition's queue so
+// that the pages land on the node whose cores run the partition.
+//
+// A device that cannot be partitioned this way (a single NUMA node, or no
+// affinity-domain support in the runtime) stays one partition.
+//
+// Header-only so that the task programs can include it directly; include
+// <CL/cl.h> with the wanted CL_TARGET_OPENCL_VERSION first.
+
+namespace kernels::numa {
+
+inline void check(cl_int err, const char* msg) {
+    if (err != CL_SUCCESS) {
+        std::cerr << "OpenCL error (" << err << "): " << msg << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+struct Devices {
+    cl_device_id root = nullptr;
+    // The sub-devices, or just the root device when it was not partitioned.
+    std::vector<cl_device_id> devices;
+    std::vector<cl_command_queue> queues;
+    cl_context context = nullptr;
+    bool partitioned = false;
+
+    int count() const { return static_cast<int>(devices.size()); }
+};
+
+inline Devices create(cl_platform_id platform) {
+    Devices result;
+    check(clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &result.root, nullptr), "clGetDeviceIDs CPU");
+
+    cl_device_affinity_domain domains = 0;
+    clGetDeviceInfo(result.root, CL_DEVICE_PARTITION_AFFINITY_DOMAIN, sizeof(domains), &domains, nullptr);
+    if (domains & CL_DEVICE_AFFINITY_DOMAIN_NUMA) {
+        const cl_device_partition_property properties[] = {
+            CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, CL_DEVICE_AFFINITY_DOMAIN_NUMA, 0};
+        cl_uint count = 0;
+        if (clCreateSubDevices(result.root, properties, 0, nullptr, &count) == CL_SUCCESS && count > 1) {
+            result.devices.resize(count);
+            check(clCreateSubDevices(result.root, properties, count, result.devices.data(), nullptr),
+                  "clCreateSubDevices");
+            result.partitioned = true;
+        }
+    }
+    if (!result.partitioned) result.devices = {result.root};
+
+    cl_int err;
+    result.context = clCreateContext(nullptr, result.devices.size(), result.devices.data(), nullptr, nullptr, &err);
+    check(err, "clCreateContext");
+    for (cl_device_id device : result.devices) {
+        result.queues.push_back(clCreateCommandQueueWithProperties(result.context, device, nullptr, &err));
+        check(err, "clCreateCommandQueue");
+    }
+    return result;
+}
+
+inline void release(Devices& devices) {
+    for (cl_command_queue queue : devices.queues) clReleaseCommandQueue(queue);
+    clReleaseContext(devices.context);
+    if (devices.partitioned) {
+        for (cl_device_id device : devices.devices) clReleaseDevice(device);
+    }
+    devices = Devices();
+}
+
+// Builds source for every (sub-)device of the context.
+inline cl_program build(const Devices& devices, const char* source) {
+    cl_int err;
+    cl_program program = clCreateProgramWithSource(devices.context, 1, &source, nullptr, &err);
+    check(err, "clCreateProgramWithSource");
+
+    err = clBuildProgram(program, devices.devices.size(), devices.devices.data(), nullptr, nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        char log[4096];
+        clGetProgramBuildInfo(program, devices.devices[0], CL_PROGRAM_BUILD_LOG, sizeof(log), log, nullptr);
+        std::cerr << "Build error:\n" << log << std::endl;
+        std::exit(1);
+    }
+    return program;
+}
+
+struct Range {
+    int begin;
+    int end;
+
+    int size() const { return end - begin; }
+};
+
+// Partition index of count contiguous ranges covering [0, total), sizes
+// differing by at most one.
+inline Range range(int total, int count, int index) {
+    int base = total / count;
+    int extra = total % count;
+    int begin = index * base + (index < extra ? index : extra);
+    return {begin, begin + base + (index < extra ? 1 : 0)};
+}
+
+// A buffer of the partition, zero-filled by the partition's queue before the
+// host data (if any) is copied in. The fill runs on the sub-device's threads,
+// so the first touch places the pages on its node.
+inline cl_mem localBuffer(const Devices& devices, int partition, cl_mem_flags flags,
+                          size_t bytes, const void* host = nullptr) {
+    cl_int err;
+    cl_mem buffer = clCreateBuffer(devices.context, flags, bytes, nullptr, &err);
+    check(err, "clCreateBuffer");
+
+    cl_command_queue queue = devices.queues[partition];
+    const cl_uchar zero = 0;
+    check(clEnqueueFillBuffer(queue, buffer, &zero, sizeof(zero), 0, bytes, 0, nullptr, nullptr),
+          "clEnqueueFillBuffer");
+    if (host) {
+        check(clEnqueueWriteBuffer(queue, buffer, CL_TRUE, 0, bytes, host, 0, nullptr, nullptr),
+              "clEnqueueWriteBuffer");
+    } else {
+        check(clFinish(queue), "clFinish");
+    }
+    return buffer;
+}
+
+inline void printDevices(std::ostream& out, const Devices& devices) {
+    char name[256] = "";
+    clGetDeviceInfo(devices.root, CL_DEVICE_NAME, sizeof(name), name, nullptr);
+    out << "CPU device: " << name
+        << ", Sub-devices: " << devices.count()
+        << (devices.partitioned ? " (one per NUMA node)" : " (not partitioned)") << std::endl;
+}
+
+}  // namespace kernels::numa
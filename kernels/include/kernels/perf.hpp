@@ -0,0 +1,373 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Hardware counters and roofline figures for timed regions, built on
+// perf_event_open(2). A Counters object counts cycles, instructions, L1D and
+// LLC misses on every OpenMP thread (on the calling thread in builds without
+// OpenMP); start() and stop() bracket the region. Memory traffic is estimated
+// as LLC misses times the cache line size. Each thread's share of the region
+// is its task clock, the CPU time it ran while the region was open, which
+// includes spinning at the region's barriers.
+//
+// measureMachine() runs a multiply-add loop and a STREAM triad on the host to
+// find the peak FLOP/s and bandwidth this build can reach. report() combines
+// them with the region's flop and byte counts into arithmetic intensity and
+// the fraction of the attainable roofline min(peak, intensity * bandwidth).
+//
+// Only user-space events are counted, which works with perf_event_paranoid
+// up to 2. Events the kernel or hypervisor does not expose print as n/a.
+//
+// Header-only and C++17 so that the task programs can include it directly.
+// Including <mpi.h> first adds the per-rank variants.
+
+namespace kernels::perf {
+
+enum Event { Cycles, Instructions, L1Misses, LLCLoadMisses, LLCStoreMisses, TaskClock, numEvents };
+
+struct Counts {
+    // Wall time of the region.
+    double seconds = 0.0;
+    // Scaled for multiplexing; negative when the event could not be opened.
+    // TaskClock is in nanoseconds.
+    double value[numEvents] = {-1.0, -1.0, -1.0, -1.0, -1.0, -1.0};
+
+    double cpuSeconds() const { return value[TaskClock] < 0 ? -1.0 : value[TaskClock] * 1e-9; }
+
+    double traffic() const {
+        if (value[LLCLoadMisses] < 0) return -1.0;
+        long line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+        double misses = value[LLCLoadMisses] + std::max(value[LLCStoreMisses], 0.0);
+        return misses * (line > 0 ? line : 64);
+    }
+
+    Counts& operator+=(const Counts& other) {
+        seconds = std::max(seconds, other.seconds);
+        for (int e = 0; e < numEvents; ++e) {
+            if (other.value[e] < 0) continue;
+            value[e] = std::max(value[e], 0.0) + other.value[e];
+        }
+        return *this;
+    }
+};
+
+inline int openEvent(std::uint32_t type, std::uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+constexpr std::uint64_t cacheEvent(std::uint64_t cache, std::uint64_t op, std::uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+// Opens every event on the calling thread; failed events keep fd -1.
+inline std::array<int, numEvents> openThreadEvents() {
+    std::array<int, numEvents> fds;
+    fds[Cycles] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[Instructions] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[L1Misses] = openEvent(PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                                             PERF_COUNT_HW_CACHE_RESULT_MISS));
+    fds[LLCLoadMisses] = openEvent(PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                                                                  PERF_COUNT_HW_CACHE_RESULT_MISS));
+    fds[LLCStoreMisses] = openEvent(PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_WRITE,
+                                                                   PERF_COUNT_HW_CACHE_RESULT_MISS));
+    fds[TaskClock] = openEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+    return fds;
+}
+
+class Counters {
+public:
+    Counters() {
+#ifdef _OPENMP
+        // Each pool thread opens its own events; later parallel regions run
+        // on the same threads.
+        threads_.resize(omp_get_max_threads());
+        for (auto& fds : threads_) fds.fill(-1);
+#pragma omp parallel
+        threads_[omp_get_thread_num()] = openThreadEvents();
+#else
+        threads_.push_back(openThreadEvents());
+#endif
+    }
+
+    ~Counters() {
+        for (auto& fds : threads_)
+            for (int fd : fds)
+                if (fd >= 0) close(fd);
+    }
+
+    Counters(const Counters&) = delete;
+    Counters& operator=(const Counters&) = delete;
+
+    bool available() const {
+        for (const auto& fds : threads_)
+            for (int fd : fds)
+                if (fd >= 0) return true;
+        return false;
+    }
+
+    void start() {
+        control(PERF_EVENT_IOC_RESET);
+        control(PERF_EVENT_IOC_ENABLE);
+        startTime_ = std::chrono::steady_clock::now();
+    }
+
+    void stop() {
+        control(PERF_EVENT_IOC_DISABLE);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime_;
+        seconds_ = elapsed.count();
+    }
+
+    std::vector<Counts> perThread() const {
+        std::vector<Counts> counts(threads_.size());
+        for (size_t t = 0; t < threads_.size(); ++t) {
+            counts[t].seconds = seconds_;
+            for (int e = 0; e < numEvents; ++e) {
+                counts[t].value[e] = readEvent(threads_[t][e]);
+            }
+        }
+        return counts;
+    }
+
+    Counts total() const {
+        Counts sum;
+        for (const Counts& counts : perThread()) sum += counts;
+        return sum;
+    }
+
+private:
+    void control(unsigned long request) {
+        for (auto& fds : threads_)
+            for (int fd : fds)
+                if (fd >= 0) ioctl(fd, request, 0);
+    }
+
+    static double readEvent(int fd) {
+        if (fd < 0) return -1.0;
+        std::uint64_t data[3];  // value, time enabled, time running
+        if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) return -1.0;
+        if (data[2] == 0) return 0.0;
+        return static_cast<double>(data[0]) * data[1] / data[2];
+    }
+
+    std::vector<std::array<int, numEvents>> threads_;
+    std::chrono::steady_clock::time_point startTime_;
+    double seconds_ = 0.0;
+};
+
+// ====Roofline====
+
+struct Machine {
+    double peakFlops = 0.0;      // flop/s
+    double peakBandwidth = 0.0;  // bytes/s
+};
+
+// Eight independent chains of 4-wide multiply-adds, enough to cover the FMA
+// latency; the compiler maps the vectors to whatever the target flags allow.
+inline double flopLoop(long iterations) {
+    typedef double Vec __attribute__((vector_size(32)));
+    Vec acc[8];
+    for (int c = 0; c < 8; ++c) acc[c] = Vec{1.0, 1.1, 1.2, 1.3} + c;
+    const Vec mul = {0.999999, 0.999999, 0.999999, 0.999999};
+    const Vec add = {1e-7, 1e-7, 1e-7, 1e-7};
+    for (long i = 0; i < iterations; ++i) {
+        for (int c = 0; c < 8; ++c) acc[c] = acc[c] * mul + add;
+    }
+    double sum = 0.0;
+    for (int c = 0; c < 8; ++c) sum += acc[c][0] + acc[c][1] + acc[c][2] + acc[c][3];
+    return sum;
+}
+
+// Best of three runs, on all OpenMP threads at once.
+inline double measurePeakFlops() {
+    const long iterations = 1L << 22;
+    const double flopsPerThread = 2.0 * 8 * 4 * iterations;
+    double sum = 0.0, best = 0.0;
+    for (int run = 0; run < 3; ++run) {
+        int threads = 1;
+        auto start = std::chrono::steady_clock::now();
+#ifdef _OPENMP
+#pragma omp parallel reduction(+ : sum)
+        {
+            sum += flopLoop(iterations);
+#pragma omp single nowait
+            threads = omp_get_num_threads();
+        }
+#else
+        sum += flopLoop(iterations);
+#endif
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::max(best, threads * flopsPerThread / elapsed.count());
+    }
+    volatile double sink = sum;
+    (void)sink;
+    return best;
+}
+
+// STREAM triad a = b + s * c; 24 bytes per element as in STREAM
+// (write-allocate traffic not counted). Best of five. The arrays of all
+// `sharers` running at once add up to four times the LLC, within
+// 48 MiB..512 MiB per caller.
+inline double measurePeakBandwidth(int sharers = 1) {
+    const size_t minBytes = size_t(48) << 20, maxBytes = size_t(512) << 20;
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    size_t bytes = llc > 0 ? 4 * static_cast<size_t>(llc) / sharers : 0;
+    size_t n = std::clamp(bytes, minBytes, maxBytes) / (3 * sizeof(double));
+    std::vector<double> a(n), b(n), c(n);
+    const double scalar = 3.0;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = 0.0;
+        b[i] = 1.0;
+        c[i] = 2.0;
+    }
+
+    double best = 0.0;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (size_t i = 0; i < n; ++i) {
+            a[i] = b[i] + scalar * c[i];
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::max(best, 3.0 * sizeof(double) * n / elapsed.count());
+    }
+    volatile double sink = a[n / 2];
+    (void)sink;
+    return best;
+}
+
+inline Machine measureMachine(int sharers = 1) {
+    Machine machine;
+    machine.peakFlops = measurePeakFlops();
+    machine.peakBandwidth = measurePeakBandwidth(sharers);
+    return machine;
+}
+
+// ====Reporting====
+
+inline std::string formatCount(double value) {
+    if (value < 0) return "n/a";
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+inline void printCounts(std::ostream& out, const Counts& counts) {
+    out << "Cycles: " << formatCount(counts.value[Cycles])
+        << ", Instructions: " << formatCount(counts.value[Instructions]);
+    if (counts.value[Cycles] > 0 && counts.value[Instructions] >= 0) {
+        out << ", IPC: " << counts.value[Instructions] / counts.value[Cycles];
+    }
+    out << ", L1 misses: " << formatCount(counts.value[L1Misses])
+        << ", LLC misses: " << formatCount(counts.value[LLCLoadMisses])
+        << ", Memory traffic: " << formatCount(counts.traffic()) << " B";
+}
+
+// flops and bytes are the region's algorithmic work and minimal traffic,
+// done in `seconds`; units label the per-thread (or per-rank) lines.
+inline void report(std::ostream& out, const std::string& label, const std::vector<Counts>& units,
+                   const char* unitName, double seconds, double flops, double bytes, const Machine& machine) {
+    Counts total;
+    for (const Counts& counts : units) total += counts;
+
+    out << "  [perf] " << label << ": ";
+    printCounts(out, total);
+    out << std::endl;
+
+    double intensity = flops / bytes;
+    double attainable = std::min(machine.peakFlops, intensity * machine.peakBandwidth);
+    double achieved = seconds > 0 ? flops / seconds : 0.0;
+    out << "  [roofline] " << label << ": Intensity: " << intensity << " flop/B";
+    if (total.traffic() > 0) out << " (measured " << flops / total.traffic() << ")";
+    out << ", Achieved: " << achieved * 1e-9 << " GFLOP/s"
+        << ", Attainable: " << attainable * 1e-9 << " GFLOP/s"
+        << " (" << (intensity * machine.peakBandwidth < machine.peakFlops ? "memory" : "compute") << "-bound)"
+        << ", Fraction: " << 100.0 * achieved / attainable << "%" << std::endl;
+
+    if (units.size() > 1) {
+        for (size_t u = 0; u < units.size(); ++u) {
+            out << "    " << unitName << " " << u << ": CPU time: " << formatCount(units[u].cpuSeconds()) << " s, ";
+            printCounts(out, units[u]);
+            out << std::endl;
+        }
+    }
+}
+
+inline void report(std::ostream& out, const std::string& label, const Counters& counters, double flops,
+                   double bytes, const Machine& machine) {
+    std::vector<Counts> threads = counters.perThread();
+    report(out, label, threads, "thread", threads[0].seconds, flops, bytes, machine);
+}
+
+inline void printMachine(std::ostream& out, const Machine& machine) {
+    out << "[roofline] Peak: " << machine.peakFlops * 1e-9 << " GFLOP/s"
+        << ", Bandwidth: " << machine.peakBandwidth * 1e-9 << " GB/s" << std::endl;
+}
+
+#ifdef MPI_VERSION
+
+// Every rank measures at the same time, so shared memory bandwidth is split
+// the way it is during the run; the machine is the sum over ranks.
+inline Machine measureMachine(MPI_Comm comm) {
+    MPI_Comm nodeComm;
+    int nodeSize;
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodeComm);
+    MPI_Comm_size(nodeComm, &nodeSize);
+    MPI_Comm_free(&nodeComm);
+
+    MPI_Barrier(comm);
+    Machine local = measureMachine(nodeSize);
+    Machine total;
+    MPI_Allreduce(&local.peakFlops, &total.peakFlops, 1, MPI_DOUBLE, MPI_SUM, comm);
+    MPI_Allreduce(&local.peakBandwidth, &total.peakBandwidth, 1, MPI_DOUBLE, MPI_SUM, comm);
+    return total;
+}
+
+// Collective: gathers each rank's totals and prints them on rank 0. The
+// roofline uses rank 0's region time, which spans the whole distributed step.
+inline void report(std::ostream& out, const std::string& label, const Counters& counters, double flops,
+                   double bytes, const Machine& machine, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    Counts mine = counters.total();
+    std::vector<Counts> ranks(rank == 0 ? size : 0);
+    MPI_Gather(&mine, sizeof(Counts), MPI_BYTE, ranks.data(), sizeof(Counts), MPI_BYTE, 0, comm);
+    if (rank == 0) report(out, label, ranks, "rank", mine.seconds, flops, bytes, machine);
+}
+
+#endif
+
+}  // namespace kernels::perf
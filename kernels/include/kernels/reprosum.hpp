@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+// Bit-reproducible floating-point summation (indexed / binned summation after
+// Demmel and Nguyen). Bins are fixed binades of width W on a global grid; a
+// value is split into exact pieces, one per bin, by rounding against each
+// bin's boundary, and an accumulator keeps REPRO_FOLDS consecutive bins below
+// the highest one it has seen. Every bin sum is exact in double, so
+// accumulators can be built and merged in any order, on any number of
+// threads, ranks or work-groups, and the final bits depend only on the data
+// and the total element count.
+//
+// Bins above maxBin, which only values within a few binades of the overflow
+// limit reach, have boundaries beyond the double range. An accumulator whose
+// top bin is one of them keeps its folds and boundaries scaled by
+// 2^-REPRO_SCALE; the power-of-two scaling is exact for every piece that can
+// land in its window, so those values are binned exactly like the others.
+// Only infinities and NaN bypass the bins.
+//
+// Usage: build ReproParams from the global element count, accumulate each part
+// into its own ReproAccumulator, merge them with reproMerge, then finalize.
+//
+// Header-only and C++17 so that the task programs can include it directly.
+// The OpenCL kernel in task-2/opencl mirrors this code.
+
+#define REPRO_FOLDS 3
+#define REPRO_BLOCK 1024
+// Binades by which scaled accumulators are shifted down.
+#define REPRO_SCALE 128
+
+namespace kernels {
+
+struct ReproParams {
+    // Bin width in binades. Pieces in a bin are below 2^(width - 1) units of
+    // that bin, so width = 52 - ceil(log2 count) keeps every bin sum exact.
+    int width;
+    // Highest bin whose boundary is a finite double.
+    int maxBin;
+};
+
+struct ReproAccumulator {
+    // fold[k] holds the exact sum of the pieces in bin (top - k); top is -1
+    // while nothing has been added.
+    int top;
+    // Non-zero once top is above maxBin: fold[k] then holds its sum times
+    // 2^-REPRO_SCALE. Kept here so that merges do not need the params.
+    int scaled;
+    double fold[REPRO_FOLDS];
+    // Plain sum of infinities and NaN.
+    double special;
+};
+
+inline ReproParams reproParams(long long count) {
+    int bits = 1;
+    while ((1LL << bits) < count && bits < 40) ++bits;
+
+    ReproParams params;
+    params.width = 52 - bits;
+    // Boundary of bin b is 1.5 * 2^(b * width - 1022).
+    params.maxBin = (1023 + 1022) / params.width;
+    return params;
+}
+
+inline ReproAccumulator reproEmpty() {
+    ReproAccumulator acc{};
+    acc.top = -1;
+    return acc;
+}
+
+// Lowest bin whose pieces above it are all zero for |x| <= maxAbs, i.e.
+// maxAbs < 2^(width - 1) units of the bin; the unit of bin b is
+// 2^(b * width - 1074). Monotonic in maxAbs, so the top bin of the whole sum
+// is the same however the data is split into blocks.
+inline int reproBin(const ReproParams& params, double maxAbs) {
+    if (maxAbs == 0.0) return 0;
+    int exponent;
+    std::frexp(maxAbs, &exponent);
+    int needed = exponent - params.width + 1 + 1074;
+    return needed <= 0 ? 0 : (needed + params.width - 1) / params.width;
+}
+
+// Boundary of the bin, scaled by 2^-scale.
+inline double reproBoundary(const ReproParams& params, int bin, int scale) {
+    return std::ldexp(1.5, bin * params.width - 1022 - scale);
+}
+
+// Moves the accumulator's window up so that its top bin is `top`; bins that
+// fall out of the window only ever hold pieces below the final resolution.
+inline void reproRaise(ReproAccumulator& acc, int top) {
+    if (top <= acc.top) return;
+    int shift = acc.top < 0 ? REPRO_FOLDS : top - acc.top;
+    for (int k = REPRO_FOLDS - 1; k >= 0; --k) {
+        acc.fold[k] = (k - shift >= 0) ? acc.fold[k - shift] : 0.0;
+    }
+    acc.top = top;
+}
+
+// Switches the accumulator to the scaled representation. Only called with top
+// above maxBin, so every fold left in the window is a multiple of a unit far
+// above the subnormal range and the scaling is exact.
+inline void reproScaleDown(ReproAccumulator& acc) {
+    if (acc.scaled) return;
+    for (int k = 0; k < REPRO_FOLDS; ++k) {
+        acc.fold[k] = std::ldexp(acc.fold[k], -REPRO_SCALE);
+    }
+    acc.scaled = 1;
+}
+
+template <typename T>
+inline void reproAccumulateBlock(const ReproParams& params, const T* data, std::size_t n, ReproAccumulator& acc) {
+    // The max skips NaN (every comparison with it is false), so NaN is counted
+    // separately.
+    double maxAbs = 0.0;
+    int nanCount = 0;
+#pragma omp simd reduction(max : maxAbs) reduction(+ : nanCount)
+    for (std::size_t i = 0; i < n; ++i) {
+        double x = std::fabs(static_cast<double>(data[i]));
+        maxAbs = x > maxAbs ? x : maxAbs;
+        nanCount += x != x;
+    }
+
+    if (nanCount > 0 || !std::isfinite(maxAbs)) {
+        // Rare slow path: infinities or NaN.
+        for (std::size_t i = 0; i < n; ++i) {
+            double x = data[i];
+            if (std::isfinite(x)) {
+                reproAccumulateBlock(params, &data[i], 1, acc);
+            } else {
+                acc.special += x;
+            }
+        }
+        return;
+    }
+
+    int bin = reproBin(params, maxAbs);
+    reproRaise(acc, bin);
+    if (bin > params.maxBin) reproScaleDown(acc);
+    const int scale = acc.scaled ? REPRO_SCALE : 0;
+    const double factor = std::ldexp(1.0, -scale);
+    const double m0 = reproBoundary(params, acc.top, scale);
+    const double m1 = reproBoundary(params, acc.top - 1, scale);
+    const double m2 = reproBoundary(params, acc.top - 2, scale);
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0;
+
+    // Each fold adds x rounded to its bin's unit and passes on the exact
+    // remainder. Lane-wise partial sums are exact, so the simd reduction is
+    // safe. Scaling x loses only bits far below the unit of the lowest bin.
+#pragma omp simd reduction(+ : s0, s1, s2)
+    for (std::size_t i = 0; i < n; ++i) {
+        double x = static_cast<double>(data[i]) * factor;
+        double q0 = (m0 + x) - m0;
+        x -= q0;
+        double q1 = (m1 + x) - m1;
+        x -= q1;
+        double q2 = (m2 + x) - m2;
+        s0 += q0;
+        s1 += q1;
+        s2 += q2;
+    }
+
+    acc.fold[0] += s0;
+    acc.fold[1] += s1;
+    acc.fold[2] += s2;
+}
+
+// One pass over the data in cache-sized blocks: the block max picks the bin,
+// the folds reuse the block from cache.
+template <typename T>
+inline void reproAccumulate(const ReproParams& params, const T* data, std::size_t n, ReproAccumulator& acc) {
+    for (std::size_t begin = 0; begin < n; begin += REPRO_BLOCK) {
+        std::size_t length = n - begin < REPRO_BLOCK ? n - begin : REPRO_BLOCK;
+        reproAccumulateBlock(params, data + begin, length, acc);
+    }
+}
+
+inline void reproMerge(ReproAccumulator& into, const ReproAccumulator& from) {
+    into.special += from.special;
+    if (from.top < 0) return;
+
+    reproRaise(into, from.top);
+    if (from.scaled) reproScaleDown(into);
+    // An unscaled from below a scaled into only overlaps its window in bins
+    // near maxBin, where the scaling is exact.
+    const double factor = into.scaled && !from.scaled ? std::ldexp(1.0, -REPRO_SCALE) : 1.0;
+    int shift = into.top - from.top;
+    for (int k = shift; k < REPRO_FOLDS; ++k) {
+        into.fold[k] += from.fold[k - shift] * factor;
+    }
+}
+
+inline double reproFinalize(const ReproAccumulator& acc) {
+    double sum = acc.fold[REPRO_FOLDS - 1];
+    for (int k = REPRO_FOLDS - 2; k >= 0; --k) {
+        sum = acc.fold[k] + sum;
+    }
+    return std::ldexp(sum, acc.scaled ? REPRO_SCALE : 0) + acc.special;
+}
+
+}  // namespace kernels
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Dynamic master/worker row scheduling for the --dynamic mode of the task 3
+// and 4 MPI programs. Rank 0 calls distributeTiles() to hand out row tiles of
+// its input and receive the result rows in place; ranks 1.. call workTiles()
+// with the per-tile computation. Rows are described by an MPI datatype whose
+// extent is the row stride of the master's matrices, so tiles go out of and
+// back into them without packing; workers see contiguous rows of `cols`
+// doubles.
+//
+// Tile sizes follow guided self-scheduling: half of the remaining rows split
+// across the workers, so tiles start large and shrink towards minTileRows near
+// the end. Every worker has up to tilesAhead tiles in flight and keeps the
+// next tile's receive posted while computing; a result doubles as the request
+// for more work, and an empty tile tells a worker to stop.
+//
+// Header-only so that the task programs can include it directly.
+
+namespace kernels::schedule {
+
+constexpr int tagTile = 2;
+constexpr int tagResult = 3;
+constexpr int minTileRows = 2;
+// Tiles in flight per worker: one being computed, one already queued.
+constexpr int tilesAhead = 2;
+
+inline int nextTileRows(int remainingRows, int numWorkers) {
+    int rows = (remainingRows + 2 * numWorkers - 1) / (2 * numWorkers);
+    return std::min(remainingRows, std::max(rows, minTileRows));
+}
+
+// Largest tile a worker can receive, which sizes its buffers.
+inline int maxTileRows(int rows, int numWorkers) {
+    return std::max(nextTileRows(rows, std::max(numWorkers, 1)), minTileRows);
+}
+
+struct Stats {
+    int tiles = 0;
+    int lastTileRows = 0;
+};
+
+// Rank 0: schedules rows [0, rows) of `input` over the other ranks of comm and
+// receives their results into the same rows of `output`. Needs at least one
+// worker.
+inline Stats distributeTiles(MPI_Comm comm, MPI_Datatype rowType, const void* input, void* output, int rows) {
+    int numProcesses;
+    MPI_Comm_size(comm, &numProcesses);
+    const int numWorkers = numProcesses - 1;
+
+    MPI_Aint lowerBound, rowStride;
+    MPI_Type_get_extent(rowType, &lowerBound, &rowStride);
+    auto inputRow = [&](int row) { return static_cast<const char*>(input) + row * rowStride; };
+    auto outputRow = [&](int row) { return static_cast<char*>(output) + row * rowStride; };
+
+    Stats stats;
+    int nextRow = 0;
+    std::vector<MPI_Request> sendRequests;
+    std::vector<MPI_Request> resultRequests(static_cast<size_t>(numProcesses) * tilesAhead, MPI_REQUEST_NULL);
+    std::vector<bool> stopped(numProcesses, false);
+
+    auto assign = [&](int worker) {
+        if (nextRow >= rows) {
+            if (stopped[worker]) return false;
+            stopped[worker] = true;
+            sendRequests.emplace_back();
+            MPI_Isend(nullptr, 0, MPI_DOUBLE, worker, tagTile, comm, &sendRequests.back());
+            return false;
+        }
+        int startRow = nextRow;
+        int numRows = nextTileRows(rows - nextRow, numWorkers);
+        nextRow += numRows;
+        ++stats.tiles;
+        stats.lastTileRows = numRows;
+
+        sendRequests.emplace_back();
+        MPI_Isend(inputRow(startRow), numRows, rowType, worker, tagTile, comm, &sendRequests.back());
+
+        // Results of one worker arrive in the order its tiles were sent.
+        MPI_Request* slot = &resultRequests[worker * tilesAhead];
+        while (*slot != MPI_REQUEST_NULL) ++slot;
+        MPI_Irecv(outputRow(startRow), numRows, rowType, worker, tagResult, comm, slot);
+        return true;
+    };
+
+    for (int worker = 1; worker < numProcesses; ++worker) {
+        for (int ahead = 0; ahead < tilesAhead; ++ahead) {
+            if (!assign(worker)) break;
+        }
+    }
+
+    int done;
+    MPI_Waitany(resultRequests.size(), resultRequests.data(), &done, MPI_STATUS_IGNORE);
+    while (done != MPI_UNDEFINED) {
+        assign(done / tilesAhead);
+        MPI_Waitany(resultRequests.size(), resultRequests.data(), &done, MPI_STATUS_IGNORE);
+    }
+    MPI_Waitall(sendRequests.size(), sendRequests.data(), MPI_STATUSES_IGNORE);
+    return stats;
+}
+
+// Ranks 1..: receives tiles from rank 0 until the empty one and returns
+// compute(input, output, numRows) for each, both contiguous rows of `cols`
+// doubles. `rows` is the row count rank 0 distributes.
+template <typename Compute>
+void workTiles(MPI_Comm comm, int rows, int cols, Compute compute) {
+    int numProcesses;
+    MPI_Comm_size(comm, &numProcesses);
+    const int tileCount = maxTileRows(rows, numProcesses - 1) * cols;
+
+    std::vector<double> input[2], output[2];
+    for (int b = 0; b < 2; ++b) {
+        input[b].resize(tileCount);
+        output[b].resize(tileCount);
+    }
+    MPI_Request recvRequest[2], sendRequest[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+
+    int current = 0;
+    MPI_Irecv(input[0].data(), tileCount, MPI_DOUBLE, 0, tagTile, comm, &recvRequest[0]);
+    while (true) {
+        MPI_Status status;
+        MPI_Wait(&recvRequest[current], &status);
+        int count;
+        MPI_Get_count(&status, MPI_DOUBLE, &count);
+        if (count == 0) break;
+
+        int next = 1 - current;
+        MPI_Irecv(input[next].data(), tileCount, MPI_DOUBLE, 0, tagTile, comm, &recvRequest[next]);
+
+        MPI_Wait(&sendRequest[current], MPI_STATUS_IGNORE);
+        compute(input[current].data(), output[current].data(), count / cols);
+        MPI_Isend(output[current].data(), count, MPI_DOUBLE, 0, tagResult, comm, &sendRequest[current]);
+
+        current = next;
+    }
+    MPI_Waitall(2, sendRequest, MPI_STATUSES_IGNORE);
+}
+
+}  // namespace kernels::schedule
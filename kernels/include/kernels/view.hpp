@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+namespace kernels {
+
+// Non-owning 1-D view with an element stride, for columns or every k-th
+// element of caller memory. Contiguous data can use std::span directly.
+template <typename T>
+class VectorView {
+public:
+    VectorView() = default;
+    VectorView(T* data, std::size_t size, std::ptrdiff_t stride = 1)
+        : data_(data), size_(size), stride_(stride) {}
+    VectorView(std::span<T> span) : data_(span.data()), size_(span.size()), stride_(1) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+    VectorView(const VectorView<U>& other) : data_(other.data()), size_(other.size()), stride_(other.stride()) {}
+
+    T& operator[](std::size_t i) const { return data_[static_cast<std::ptrdiff_t>(i) * stride_]; }
+
+    T* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::ptrdiff_t stride() const { return stride_; }
+    bool contiguous() const { return stride_ == 1; }
+
+private:
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::ptrdiff_t stride_ = 1;
+};
+
+enum class Layout { RowMajor, ColMajor, Strided };
+
+// Non-owning 2-D view in the spirit of std::mdspan with layout_stride:
+// element (i, j) lives at data[i * rowStride + j * colStride]. Row-major
+// blocks of a larger matrix keep rowStride = leading dimension of the parent,
+// so kernels run on sub-blocks in place.
+template <typename T>
+class MatrixView {
+public:
+    MatrixView() = default;
+    MatrixView(T* data, std::size_t rows, std::size_t cols, std::ptrdiff_t rowStride, std::ptrdiff_t colStride)
+        : data_(data), rows_(rows), cols_(cols), rowStride_(rowStride), colStride_(colStride) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+    MatrixView(const MatrixView<U>& other)
+        : data_(other.data()), rows_(other.rows()), cols_(other.cols()),
+          rowStride_(other.rowStride()), colStride_(other.colStride()) {}
+
+    static MatrixView rowMajor(T* data, std::size_t rows, std::size_t cols) {
+        return MatrixView(data, rows, cols, static_cast<std::ptrdiff_t>(cols), 1);
+    }
+    static MatrixView rowMajor(T* data, std::size_t rows, std::size_t cols, std::size_t leadingDim) {
+        return MatrixView(data, rows, cols, static_cast<std::ptrdiff_t>(leadingDim), 1);
+    }
+    static MatrixView colMajor(T* data, std::size_t rows, std::size_t cols) {
+        return MatrixView(data, rows, cols, 1, static_cast<std::ptrdiff_t>(rows));
+    }
+    static MatrixView colMajor(T* data, std::size_t rows, std::size_t cols, std::size_t leadingDim) {
+        return MatrixView(data, rows, cols, 1, static_cast<std::ptrdiff_t>(leadingDim));
+    }
+
+    T& operator()(std::size_t i, std::size_t j) const {
+        return data_[static_cast<std::ptrdiff_t>(i) * rowStride_ + static_cast<std::ptrdiff_t>(j) * colStride_];
+    }
+
+    T* data() const { return data_; }
+    std::size_t rows() const { return rows_; }
+    std::size_t cols() const { return cols_; }
+    std::ptrdiff_t rowStride() const { return rowStride_; }
+    std::ptrdiff_t colStride() const { return colStride_; }
+
+    Layout layout() const {
+        if (colStride_ == 1) return Layout::RowMajor;
+        if (rowStride_ == 1) return Layout::ColMajor;
+        return Layout::Strided;
+    }
+
+    MatrixView block(std::size_t row, std::size_t col, std::size_t numRows, std::size_t numCols) const {
+        return MatrixView(&(*this)(row, col), numRows, numCols, rowStride_, colStride_);
+    }
+
+    MatrixView transposed() const {
+        return MatrixView(data_, cols_, rows_, colStride_, rowStride_);
+    }
+
+    VectorView<T> row(std::size_t i) const { return VectorView<T>(&(*this)(i, 0), cols_, colStride_); }
+    VectorView<T> col(std::size_t j) const { return VectorView<T>(&(*this)(0, j), rows_, rowStride_); }
+
+private:
+    T* data_ = nullptr;
+    std::size_t rows_ = 0;
+    std::size_t cols_ = 0;
+    std::ptrdiff_t rowStride_ = 0;
+    std::ptrdiff_t colStride_ = 1;
+};
+
+}  // namespace kernels
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Support for the compile-time size-specialised kernels. Each kernel file
+// instantiates its fixed-size variant for every entry of FixedSizes and keeps
+// them in a table indexed by size at run time; sizes that are not in the
+// table take the generic path.
+namespace kernels::fixed {
+
+// Benchmark sizes of tasks 2-4 plus common power-of-two tiles.
+using FixedSizes = std::integer_sequence<int, 8, 10, 16, 32, 64, 100, 128, 256, 1000>;
+
+// Loops up to this trip count are unrolled completely at compile time; longer
+// ones keep a loop, but with a constant trip count and no remainder handling.
+constexpr int maxUnrolled = 16;
+
+// Below this many inner-loop iterations a kernel stays on the calling thread:
+// starting the OpenMP team costs more than the work.
+constexpr std::size_t parallelWork = 1 << 15;
+
+template <typename F, std::size_t... I>
+inline void unrollImpl(F&& f, std::index_sequence<I...>) {
+    (f(std::integral_constant<std::size_t, I>{}), ...);
+}
+
+// Calls f(0), f(1), ..., f(N - 1) with compile-time constant indices.
+template <std::size_t N, typename F>
+inline void unroll(F&& f) {
+    unrollImpl(f, std::make_index_sequence<N>{});
+}
+
+template <typename Fn>
+struct Entry {
+    int size;
+    Fn fn;
+};
+
+template <typename Fn, std::size_t N>
+Fn find(const std::array<Entry<Fn>, N>& table, std::size_t size) {
+    for (const auto& entry : table) {
+        if (static_cast<std::size_t>(entry.size) == size) return entry.fn;
+    }
+    return nullptr;
+}
+
+}  // namespace kernels::fixed
@@ -0,0 +1,147 @@
+#include "kernels/kernels.hpp"
+#include "fixed.hpp"
+
+#include <omp.h>
+
+#include <stdexcept>
+
+namespace kernels {
+
+namespace {
+
+// B and C have unit column stride: i-k-j order streams rows of B and C.
+template <typename T>
+void gemmRowMajor(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C) {
+    const std::ptrdiff_t rows = static_cast<std::ptrdiff_t>(C.rows());
+    const std::ptrdiff_t cols = static_cast<std::ptrdiff_t>(C.cols());
+    const std::ptrdiff_t inner = static_cast<std::ptrdiff_t>(A.cols());
+
+#pragma omp parallel for schedule(static)
+    for (std::ptrdiff_t i = 0; i < rows; ++i) {
+        T* c = &C(i, 0);
+        for (std::ptrdiff_t j = 0; j < cols; ++j) {
+            c[j] = 0;
+        }
+        for (std::ptrdiff_t k = 0; k < inner; ++k) {
+            const T a = A(i, k);
+            const T* b = &B(k, 0);
+#pragma omp simd
+            for (std::ptrdiff_t j = 0; j < cols; ++j) {
+                c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+// Row-major GEMM with the inner and column dimensions fixed at compile time;
+// only the number of rows, which differs between distributed row blocks, is
+// left to run time. Small sizes accumulate a row of C in registers with every
+// loop unrolled.
+template <typename T, int Inner, int Cols>
+void gemmFixed(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C) {
+    const std::ptrdiff_t rows = static_cast<std::ptrdiff_t>(C.rows());
+    const bool parallel = C.rows() * Inner * Cols >= fixed::parallelWork;
+
+#pragma omp parallel for schedule(static) if (parallel)
+    for (std::ptrdiff_t i = 0; i < rows; ++i) {
+        T* c = &C(i, 0);
+        if constexpr (Inner <= fixed::maxUnrolled && Cols <= fixed::maxUnrolled) {
+            T acc[Cols] = {};
+            fixed::unroll<Inner>([&](auto k) {
+                const T a = A(i, k);
+                const T* b = &B(k, 0);
+                fixed::unroll<Cols>([&](auto j) { acc[j] += a * b[j]; });
+            });
+            fixed::unroll<Cols>([&](auto j) { c[j] = acc[j]; });
+        } else {
+            // A local row cannot alias B, so the simd loop needs no overlap checks.
+            T acc[Cols] = {};
+            for (int k = 0; k < Inner; ++k) {
+                const T a = A(i, k);
+                const T* b = &B(k, 0);
+#pragma omp simd
+                for (int j = 0; j < Cols; ++j) {
+                    acc[j] += a * b[j];
+                }
+            }
+            for (int j = 0; j < Cols; ++j) {
+                c[j] = acc[j];
+            }
+        }
+    }
+}
+
+template <typename T>
+using GemmFn = void (*)(MatrixView<const T>, MatrixView<const T>, MatrixView<T>);
+
+template <typename T, int... Sizes>
+constexpr auto makeGemmTable(std::integer_sequence<int, Sizes...>) {
+    return std::array<fixed::Entry<GemmFn<T>>, sizeof...(Sizes)>{{{Sizes, &gemmFixed<T, Sizes, Sizes>}...}};
+}
+
+// Square inner x cols shapes from FixedSizes.
+template <typename T>
+constexpr auto gemmTable = makeGemmTable<T>(fixed::FixedSizes{});
+
+template <typename T>
+void gemmRowMajorDispatch(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C) {
+    if (A.cols() == C.cols()) {
+        if (GemmFn<T> fn = fixed::find(gemmTable<T>, C.cols())) {
+            fn(A, B, C);
+            return;
+        }
+    }
+    gemmRowMajor<T>(A, B, C);
+}
+
+template <typename T>
+void gemmGeneric(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C) {
+    const std::ptrdiff_t rows = static_cast<std::ptrdiff_t>(C.rows());
+    const std::ptrdiff_t cols = static_cast<std::ptrdiff_t>(C.cols());
+    const std::ptrdiff_t inner = static_cast<std::ptrdiff_t>(A.cols());
+
+#pragma omp parallel for collapse(2) schedule(static)
+    for (std::ptrdiff_t i = 0; i < rows; ++i) {
+        for (std::ptrdiff_t j = 0; j < cols; ++j) {
+            T sum = 0;
+            for (std::ptrdiff_t k = 0; k < inner; ++k) {
+                sum += A(i, k) * B(k, j);
+            }
+            C(i, j) = sum;
+        }
+    }
+}
+
+template <typename T>
+void gemmImpl(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C) {
+    if (A.cols() != B.rows() || C.rows() != A.rows() || C.cols() != B.cols()) {
+        throw std::invalid_argument("gemm: incompatible dimensions");
+    }
+    if (C.rows() == 0 || C.cols() == 0) return;
+
+    if (B.colStride() == 1 && C.colStride() == 1) {
+        gemmRowMajorDispatch<T>(A, B, C);
+    } else if (A.rowStride() == 1 && C.rowStride() == 1) {
+        // Column-major operands: C^T = B^T * A^T, and the transposes are
+        // row-major views of the same memory.
+        gemmRowMajorDispatch<T>(B.transposed(), A.transposed(), C.transposed());
+    } else {
+        gemmGeneric<T>(A, B, C);
+    }
+}
+
+}  // namespace
+
+void gemm(MatrixView<const double> A, MatrixView<const double> B, MatrixView<double> C) {
+    gemmImpl<double>(A, B, C);
+}
+
+void gemm(MatrixView<const float> A, MatrixView<const float> B, MatrixView<float> C) {
+    gemmImpl<float>(A, B, C);
+}
+
+void gemm(MatrixView<const int> A, MatrixView<const int> B, MatrixView<int> C) {
+    gemmImpl<int>(A, B, C);
+}
+
+}  // namespace kernels
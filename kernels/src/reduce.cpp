@@ -0,0 +1,121 @@
+#include "kernels/kernels.hpp"
+#include "kernels/reprosum.hpp"
+#include "fixed.hpp"
+
+#include <omp.h>
+
+namespace kernels {
+
+namespace {
+
+template <typename Acc, typename T>
+Acc sumContiguous(const T* data, std::ptrdiff_t n) {
+    Acc total = 0;
+#pragma omp parallel for simd reduction(+ : total) schedule(static)
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        total += data[i];
+    }
+    return total;
+}
+
+// Exactly N elements on the calling thread, with `lanes` independent partial
+// sums so that the adds pipeline; both loops have constant trip counts and the
+// tail is unrolled.
+template <typename Acc, typename T, int N>
+Acc sumFixed(const T* data) {
+    constexpr int lanes = 8;
+    Acc partial[lanes] = {};
+    for (int i = 0; i < N / lanes; ++i) {
+        fixed::unroll<lanes>([&](auto l) { partial[l] += data[i * lanes + l]; });
+    }
+    fixed::unroll<N % lanes>([&](auto l) { partial[l] += data[N / lanes * lanes + l]; });
+
+    Acc total = 0;
+    fixed::unroll<lanes>([&](auto l) { total += partial[l]; });
+    return total;
+}
+
+template <typename Acc, typename T>
+using SumFn = Acc (*)(const T*);
+
+template <typename Acc, typename T, int... Sizes>
+constexpr auto makeSumTable(std::integer_sequence<int, Sizes...>) {
+    return std::array<fixed::Entry<SumFn<Acc, T>>, sizeof...(Sizes)>{{{Sizes, &sumFixed<Acc, T, Sizes>}...}};
+}
+
+// Element counts from FixedSizes.
+template <typename Acc, typename T>
+constexpr auto sumTable = makeSumTable<Acc, T>(fixed::FixedSizes{});
+
+template <typename Acc, typename T>
+Acc sumDispatch(const T* data, std::ptrdiff_t n) {
+    if (SumFn<Acc, T> fn = fixed::find(sumTable<Acc, T>, static_cast<std::size_t>(n))) {
+        return fn(data);
+    }
+    return sumContiguous<Acc>(data, n);
+}
+
+template <typename Acc, typename T>
+Acc sumStrided(VectorView<const T> data) {
+    const std::ptrdiff_t n = static_cast<std::ptrdiff_t>(data.size());
+    if (data.contiguous()) return sumDispatch<Acc>(data.data(), n);
+
+    const T* base = data.data();
+    const std::ptrdiff_t stride = data.stride();
+    Acc total = 0;
+#pragma omp parallel for reduction(+ : total) schedule(static)
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        total += base[i * stride];
+    }
+    return total;
+}
+
+template <typename T>
+double sumReproducible(const T* data, std::size_t n) {
+    const ReproParams params = reproParams(static_cast<long long>(n));
+    ReproAccumulator total = reproEmpty();
+
+#pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        std::size_t begin = n * thread / threads;
+        std::size_t end = n * (thread + 1) / threads;
+
+        ReproAccumulator acc = reproEmpty();
+        reproAccumulate(params, data + begin, end - begin, acc);
+
+        // Merges are exact, so the order in which threads arrive is irrelevant.
+#pragma omp critical
+        reproMerge(total, acc);
+    }
+    return reproFinalize(total);
+}
+
+}  // namespace
+
+long long reduceSum(std::span<const int> data) {
+    return sumDispatch<long long>(data.data(), static_cast<std::ptrdiff_t>(data.size()));
+}
+
+long long reduceSum(VectorView<const int> data) {
+    return sumStrided<long long>(data);
+}
+
+double reduceSum(std::span<const double> data) {
+    return sumDispatch<double>(data.data(), static_cast<std::ptrdiff_t>(data.size()));
+}
+
+double reduceSum(VectorView<const double> data) {
+    return sumStrided<double>(data);
+}
+
+double reduceSumReproducible(std::span<const double> data) {
+    return sumReproducible(data.data(), data.size());
+}
+
+float reduceSumReproducible(std::span<const float> data) {
+    return static_cast<float>(sumReproducible(data.data(), data.size()));
+}
+
+}  // namespace kernels
@@ -0,0 +1,102 @@
+#include "kernels/kernels.hpp"
+#include "fixed.hpp"
+
+#include <omp.h>
+
+#include <stdexcept>
+
+namespace kernels {
+
+namespace {
+
+// Unit-stride rows with the column count fixed at compile time: the boundary
+// columns sit at constant offsets and narrow rows are unrolled completely.
+template <typename T, int Cols>
+void derivativeXFixed(MatrixView<const T> input, MatrixView<T> output, T dx) {
+    const std::ptrdiff_t rows = static_cast<std::ptrdiff_t>(input.rows());
+    const bool parallel = input.rows() * Cols >= fixed::parallelWork;
+
+#pragma omp parallel for schedule(static) if (parallel)
+    for (std::ptrdiff_t i = 0; i < rows; ++i) {
+        const T* in = &input(i, 0);
+        T* out = &output(i, 0);
+        out[0] = (in[1] - in[0]) / dx;
+        if constexpr (Cols <= fixed::maxUnrolled) {
+            fixed::unroll<Cols - 2>([&](auto j) { out[j + 1] = (in[j + 2] - in[j]) / (2 * dx); });
+        } else {
+#pragma omp simd
+            for (int j = 1; j < Cols - 1; ++j) {
+                out[j] = (in[j + 1] - in[j - 1]) / (2 * dx);
+            }
+        }
+        out[Cols - 1] = (in[Cols - 1] - in[Cols - 2]) / dx;
+    }
+}
+
+template <typename T>
+using DerivativeFn = void (*)(MatrixView<const T>, MatrixView<T>, T);
+
+template <typename T, int... Sizes>
+constexpr auto makeDerivativeTable(std::integer_sequence<int, Sizes...>) {
+    return std::array<fixed::Entry<DerivativeFn<T>>, sizeof...(Sizes)>{{{Sizes, &derivativeXFixed<T, Sizes>}...}};
+}
+
+// Column counts from FixedSizes.
+template <typename T>
+constexpr auto derivativeTable = makeDerivativeTable<T>(fixed::FixedSizes{});
+
+template <typename T>
+void derivativeXImpl(MatrixView<const T> input, MatrixView<T> output, T dx) {
+    if (input.rows() != output.rows() || input.cols() != output.cols()) {
+        throw std::invalid_argument("derivativeX: input and output shapes differ");
+    }
+    if (input.rows() > 0 && input.cols() < 2) {
+        throw std::invalid_argument("derivativeX: at least 2 columns are required");
+    }
+
+    const std::ptrdiff_t rows = static_cast<std::ptrdiff_t>(input.rows());
+    const std::ptrdiff_t cols = static_cast<std::ptrdiff_t>(input.cols());
+
+    if (input.colStride() == 1 && output.colStride() == 1) {
+        if (DerivativeFn<T> fn = fixed::find(derivativeTable<T>, input.cols())) {
+            fn(input, output, dx);
+            return;
+        }
+
+        // Unit-stride rows: boundary columns are peeled so the interior loop
+        // has no branches.
+#pragma omp parallel for schedule(static)
+        for (std::ptrdiff_t i = 0; i < rows; ++i) {
+            const T* in = &input(i, 0);
+            T* out = &output(i, 0);
+            out[0] = (in[1] - in[0]) / dx;
+#pragma omp simd
+            for (std::ptrdiff_t j = 1; j < cols - 1; ++j) {
+                out[j] = (in[j + 1] - in[j - 1]) / (2 * dx);
+            }
+            out[cols - 1] = (in[cols - 1] - in[cols - 2]) / dx;
+        }
+        return;
+    }
+
+#pragma omp parallel for schedule(static)
+    for (std::ptrdiff_t i = 0; i < rows; ++i) {
+        output(i, 0) = (input(i, 1) - input(i, 0)) / dx;
+        for (std::ptrdiff_t j = 1; j < cols - 1; ++j) {
+            output(i, j) = (input(i, j + 1) - input(i, j - 1)) / (2 * dx);
+        }
+        output(i, cols - 1) = (input(i, cols - 1) - input(i, cols - 2)) / dx;
+    }
+}
+
+}  // namespace
+
+void derivativeX(MatrixView<const double> input, MatrixView<double> output, double dx) {
+    derivativeXImpl<double>(input, output, dx);
+}
+
+void derivativeX(MatrixView<const float> input, MatrixView<float> output, float dx) {
+    derivativeXImpl<float>(input, output, dx);
+}
+
+}  // namespace kernels
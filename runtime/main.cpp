@@ -0,0 +1,107 @@
+#include "runtime.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+double computeFunction(double x, double y) {
+    return x * (sin(x) + cos(y));
+}
+
+int main(int argc, char* argv[]) {
+    unsigned int seed = 42;
+    srand(seed);
+
+    MPI_Init(&argc, &argv);
+
+    {
+        bool forceCalibration = false;
+        std::string profilePath = "profile.txt";
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--calibrate") {
+                forceCalibration = true;
+            } else {
+                profilePath = arg;
+            }
+        }
+
+        DispatchRuntime runtime(MPI_COMM_WORLD);
+        int rank = runtime.rank();
+
+        if (forceCalibration || !runtime.loadProfile(profilePath)) {
+            runtime.calibrate();
+            if (!runtime.saveProfile(profilePath)) {
+                std::cerr << "Failed to write profile " << profilePath << std::endl;
+            } else if (rank == 0) {
+                std::cout << "Profile written to " << profilePath << std::endl;
+            }
+        }
+
+        std::vector<int> arraySizes = {10, 1000, 10000000};
+        for (int n : arraySizes) {
+            std::vector<int> data(rank == 0 ? n : 0);
+            for (int& v : data) v = rand() % 10;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            long long sum = runtime.reduce(data.data(), n);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> elapsed = end - start;
+
+            if (rank == 0) {
+                std::cout << "Reduce size: " << n
+                          << ", Backend: " << backendName(runtime.lastBackend())
+                          << ", Sum: " << sum
+                          << ", Time: " << elapsed.count() << " s" << std::endl;
+            }
+        }
+
+        const double dx = 0.01;
+        std::vector<int> gridSizes = {10, 100, 1000, 4000};
+        for (int n : gridSizes) {
+            size_t total = (rank == 0) ? static_cast<size_t>(n) * n : 0;
+            std::vector<double> grid(total), derivative(total);
+            if (rank == 0) {
+                for (int i = 0; i < n; ++i)
+                    for (int j = 0; j < n; ++j)
+                        grid[static_cast<size_t>(i) * n + j] = computeFunction(i * dx, j * dx);
+            }
+
+            auto start = std::chrono::high_resolution_clock::now();
+            runtime.stencil(grid.data(), derivative.data(), n, n, dx);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> elapsed = end - start;
+
+            if (rank == 0) {
+                std::cout << "Stencil size: " << n << "x" << n
+                          << ", Backend: " << backendName(runtime.lastBackend())
+                          << ", Time: " << elapsed.count() << " s" << std::endl;
+            }
+        }
+
+        std::vector<int> matrixSizes = {10, 100, 1000};
+        for (int n : matrixSizes) {
+            size_t total = (rank == 0) ? static_cast<size_t>(n) * n : 0;
+            std::vector<double> A(total), B(total), C(total);
+            for (double& v : A) v = rand() % 10;
+            for (double& v : B) v = rand() % 10;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            runtime.gemm(A.data(), B.data(), C.data(), n);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> elapsed = end - start;
+
+            if (rank == 0) {
+                std::cout << "Gemm size: " << n << "x" << n
+                          << ", Backend: " << backendName(runtime.lastBackend())
+                          << ", Time: " << elapsed.count() << " s" << std::endl;
+            }
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,660 @@
+#include "runtime.hpp"
+
+#include "kernels/kernels.hpp"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const char* kernelSource = R"CLC(
+#define TILE 16
+// Work-group size of reduce_sum, a power of two; set with -DREDUCE_LOCAL.
+#ifndef REDUCE_LOCAL
+#define REDUCE_LOCAL 256
+#endif
+
+__kernel void reduce_sum(__global const int* input, __global long* partialSums, const int N) {
+    int gid = get_global_id(0);
+    int groupSize = get_local_size(0);
+    int lid = get_local_id(0);
+    __local long localSums[REDUCE_LOCAL];
+
+    long sum = 0;
+    for (int i = gid; i < N; i += get_global_size(0)) {
+        sum += input[i];
+    }
+    localSums[lid] = sum;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int stride = groupSize / 2; stride > 0; stride /= 2) {
+        if (lid < stride) {
+            localSums[lid] += localSums[lid + stride];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        partialSums[get_group_id(0)] = localSums[0];
+    }
+}
+
+__kernel void computeDerivativeX(__global const double* input,
+                                 __global double* output,
+                                 const int rows,
+                                 const int cols,
+                                 const double dx) {
+    int i = get_global_id(0);
+    int j = get_global_id(1);
+    if (i >= rows || j >= cols) return;
+
+    int idx = i * cols + j;
+    if (j == 0) {
+        output[idx] = (input[idx + 1] - input[idx]) / dx;
+    } else if (j == cols - 1) {
+        output[idx] = (input[idx] - input[idx - 1]) / dx;
+    } else {
+        output[idx] = (input[idx + 1] - input[idx - 1]) / (2.0 * dx);
+    }
+}
+
+__kernel void matMulTiled(__global const double* A,
+                          __global const double* B,
+                          __global double* C,
+                          const int N) {
+    int row = get_global_id(0);
+    int col = get_global_id(1);
+    int localRow = get_local_id(0);
+    int localCol = get_local_id(1);
+
+    __local double tileA[TILE][TILE];
+    __local double tileB[TILE][TILE];
+
+    double sum = 0.0;
+    for (int t = 0; t < N; t += TILE) {
+        tileA[localRow][localCol] = (row < N && t + localCol < N) ? A[row * N + t + localCol] : 0.0;
+        tileB[localRow][localCol] = (t + localRow < N && col < N) ? B[(t + localRow) * N + col] : 0.0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (int k = 0; k < TILE; ++k) {
+            sum += tileA[localRow][k] * tileB[k][localCol];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (row < N && col < N) {
+        C[row * N + col] = sum;
+    }
+}
+)CLC";
+
+// Largest reduce_sum work-group; initOpenCL() halves it until the device fits.
+constexpr int maxReduceLocalSize = 256;
+constexpr int gemmTile = 16;
+
+void check(cl_int err, const char* msg) {
+    if (err != CL_SUCCESS) {
+        std::cerr << "OpenCL error (" << err << "): " << msg << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// Splits `total` items across `parts` ranks, the first `total % parts` ranks
+// getting one extra. Counts and displacements are scaled by `unit`.
+void splitCounts(int total, int parts, int unit, std::vector<int>& counts, std::vector<int>& displs) {
+    counts.assign(parts, 0);
+    displs.assign(parts, 0);
+    int base = total / parts;
+    int remainder = total % parts;
+    int offset = 0;
+    for (int p = 0; p < parts; ++p) {
+        int items = (p < remainder) ? base + 1 : base;
+        counts[p] = items * unit;
+        displs[p] = offset * unit;
+        offset += items;
+    }
+}
+
+Operation parseOperation(const std::string& name, bool& ok) {
+    ok = true;
+    if (name == "reduce") return Operation::Reduce;
+    if (name == "stencil") return Operation::Stencil;
+    if (name == "gemm") return Operation::Gemm;
+    ok = false;
+    return Operation::Reduce;
+}
+
+Backend parseBackend(const std::string& name, bool& ok) {
+    ok = true;
+    if (name == "openmp") return Backend::OpenMP;
+    if (name == "opencl") return Backend::OpenCL;
+    if (name == "mpi") return Backend::MPI;
+    ok = false;
+    return Backend::OpenMP;
+}
+
+}  // namespace
+
+const char* backendName(Backend backend) {
+    switch (backend) {
+        case Backend::OpenMP: return "openmp";
+        case Backend::OpenCL: return "opencl";
+        case Backend::MPI: return "mpi";
+    }
+    return "unknown";
+}
+
+const char* operationName(Operation op) {
+    switch (op) {
+        case Operation::Reduce: return "reduce";
+        case Operation::Stencil: return "stencil";
+        case Operation::Gemm: return "gemm";
+    }
+    return "unknown";
+}
+
+// ====DispatchProfile====
+
+void DispatchProfile::set(Operation op, long size, Backend backend) {
+    auto& list = entries[static_cast<int>(op)];
+    auto it = std::find_if(list.begin(), list.end(), [size](const Entry& e) { return e.size == size; });
+    if (it != list.end()) {
+        it->backend = backend;
+    } else {
+        list.push_back({size, backend});
+        std::sort(list.begin(), list.end(), [](const Entry& a, const Entry& b) { return a.size < b.size; });
+    }
+}
+
+Backend DispatchProfile::select(Operation op, long size) const {
+    const auto& list = entries[static_cast<int>(op)];
+    if (list.empty()) return Backend::OpenMP;
+
+    Backend chosen = list.front().backend;
+    for (const Entry& e : list) {
+        if (e.size > size) break;
+        chosen = e.backend;
+    }
+    return chosen;
+}
+
+bool DispatchProfile::empty() const {
+    return entries[0].empty() && entries[1].empty() && entries[2].empty();
+}
+
+std::string DispatchProfile::serialize() const {
+    std::ostringstream out;
+    out << "# operation size backend\n";
+    for (int op = 0; op < 3; ++op) {
+        for (const Entry& e : entries[op]) {
+            out << operationName(static_cast<Operation>(op)) << " " << e.size << " "
+                << backendName(e.backend) << "\n";
+        }
+    }
+    return out.str();
+}
+
+bool DispatchProfile::parse(const std::string& text) {
+    DispatchProfile parsed;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string opName, backend;
+        long size;
+        if (!(fields >> opName >> size >> backend)) return false;
+
+        bool opOk, backendOk;
+        Operation op = parseOperation(opName, opOk);
+        Backend b = parseBackend(backend, backendOk);
+        if (!opOk || !backendOk) return false;
+        parsed.set(op, size, b);
+    }
+    *this = parsed;
+    return true;
+}
+
+bool DispatchProfile::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return parse(buffer.str());
+}
+
+bool DispatchProfile::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) return false;
+    file << serialize();
+    return static_cast<bool>(file);
+}
+
+// ====DispatchRuntime====
+
+DispatchRuntime::DispatchRuntime(MPI_Comm comm) : comm_(comm) {
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &size_);
+
+    // Only rank 0 computes on the local OpenCL device; the flag is shared so
+    // that every rank walks the same backend list during calibration.
+    int ready = 0;
+    if (rank_ == 0) ready = initOpenCL() ? 1 : 0;
+    MPI_Bcast(&ready, 1, MPI_INT, 0, comm_);
+    clReady_ = ready != 0;
+}
+
+DispatchRuntime::~DispatchRuntime() {
+    releaseOpenCL();
+}
+
+bool DispatchRuntime::initOpenCL() {
+    cl_int err;
+    cl_platform_id platform;
+    if (clGetPlatformIDs(1, &platform, nullptr) != CL_SUCCESS) {
+        std::cerr << "OpenCL backend disabled: no platform." << std::endl;
+        return false;
+    }
+    if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &device_, nullptr) != CL_SUCCESS) {
+        std::cerr << "OpenCL backend disabled: no CPU device." << std::endl;
+        return false;
+    }
+
+    context_ = clCreateContext(nullptr, 1, &device_, nullptr, nullptr, &err);
+    check(err, "clCreateContext");
+    queue_ = clCreateCommandQueueWithProperties(context_, device_, nullptr, &err);
+    check(err, "clCreateCommandQueue");
+
+    // Builds with REDUCE_LOCAL = reduceLocalSize_ and rebuilds with the largest
+    // power of two the reduce kernel's work-group limit allows until it fits.
+    reduceLocalSize_ = maxReduceLocalSize;
+    while (true) {
+        program_ = clCreateProgramWithSource(context_, 1, &kernelSource, nullptr, &err);
+        check(err, "clCreateProgramWithSource");
+
+        std::string options = "-DREDUCE_LOCAL=" + std::to_string(reduceLocalSize_);
+        err = clBuildProgram(program_, 1, &device_, options.c_str(), nullptr, nullptr);
+        if (err != CL_SUCCESS) {
+            char log[4096];
+            clGetProgramBuildInfo(program_, device_, CL_PROGRAM_BUILD_LOG, sizeof(log), log, nullptr);
+            std::cerr << "OpenCL backend disabled, build error:\n" << log << std::endl;
+            releaseOpenCL();
+            return false;
+        }
+
+        reduceKernel_ = clCreateKernel(program_, "reduce_sum", &err);
+        check(err, "clCreateKernel reduce_sum");
+        stencilKernel_ = clCreateKernel(program_, "computeDerivativeX", &err);
+        check(err, "clCreateKernel computeDerivativeX");
+        gemmKernel_ = clCreateKernel(program_, "matMulTiled", &err);
+        check(err, "clCreateKernel matMulTiled");
+
+        size_t reduceGroup = 0;
+        clGetKernelWorkGroupInfo(reduceKernel_, device_, CL_KERNEL_WORK_GROUP_SIZE, sizeof(reduceGroup), &reduceGroup,
+                                 nullptr);
+        if (reduceGroup >= static_cast<size_t>(reduceLocalSize_)) break;
+        if (reduceGroup == 0) {
+            std::cerr << "OpenCL backend disabled: reduce work-group size 0." << std::endl;
+            releaseOpenCL();
+            return false;
+        }
+
+        int fit = 1;
+        while (static_cast<size_t>(fit) * 2 <= reduceGroup) fit *= 2;
+        reduceLocalSize_ = fit;
+        clReleaseKernel(gemmKernel_);
+        clReleaseKernel(stencilKernel_);
+        clReleaseKernel(reduceKernel_);
+        clReleaseProgram(program_);
+        gemmKernel_ = stencilKernel_ = reduceKernel_ = nullptr;
+        program_ = nullptr;
+    }
+
+    size_t maxGroup = 0;
+    clGetKernelWorkGroupInfo(gemmKernel_, device_, CL_KERNEL_WORK_GROUP_SIZE, sizeof(maxGroup), &maxGroup, nullptr);
+    if (maxGroup < static_cast<size_t>(gemmTile * gemmTile)) {
+        std::cerr << "OpenCL backend disabled: work-group size " << maxGroup << " is too small." << std::endl;
+        releaseOpenCL();
+        return false;
+    }
+    return true;
+}
+
+void DispatchRuntime::releaseOpenCL() {
+    if (gemmKernel_) clReleaseKernel(gemmKernel_);
+    if (stencilKernel_) clReleaseKernel(stencilKernel_);
+    if (reduceKernel_) clReleaseKernel(reduceKernel_);
+    if (program_) clReleaseProgram(program_);
+    if (queue_) clReleaseCommandQueue(queue_);
+    if (context_) clReleaseContext(context_);
+    gemmKernel_ = stencilKernel_ = reduceKernel_ = nullptr;
+    program_ = nullptr;
+    queue_ = nullptr;
+    context_ = nullptr;
+    clReady_ = false;
+}
+
+bool DispatchRuntime::available(Backend backend) const {
+    switch (backend) {
+        case Backend::OpenMP: return true;
+        case Backend::OpenCL: return clReady_;
+        case Backend::MPI: return size_ > 1;
+    }
+    return false;
+}
+
+Backend DispatchRuntime::select(Operation op, long size) const {
+    Backend backend = profile_.select(op, size);
+    return available(backend) ? backend : Backend::OpenMP;
+}
+
+void DispatchRuntime::shareProfile() {
+    std::string text = (rank_ == 0) ? profile_.serialize() : std::string();
+    int length = static_cast<int>(text.size());
+    MPI_Bcast(&length, 1, MPI_INT, 0, comm_);
+    text.resize(length);
+    MPI_Bcast(text.data(), length, MPI_CHAR, 0, comm_);
+    if (rank_ != 0) profile_.parse(text);
+}
+
+bool DispatchRuntime::loadProfile(const std::string& path) {
+    int ok = 0;
+    if (rank_ == 0) ok = profile_.load(path) && !profile_.empty() ? 1 : 0;
+    MPI_Bcast(&ok, 1, MPI_INT, 0, comm_);
+    if (ok) shareProfile();
+    return ok != 0;
+}
+
+bool DispatchRuntime::saveProfile(const std::string& path) const {
+    return rank_ != 0 || profile_.save(path);
+}
+
+void DispatchRuntime::calibrate() {
+    const std::vector<int> reduceSizes = {10, 1000, 100000, 10000000};
+    const std::vector<int> stencilSizes = {10, 100, 1000, 3000};
+    const std::vector<int> gemmSizes = {10, 100, 300, 800};
+    const int repetitions = 3;
+    const Backend backends[] = {Backend::OpenMP, Backend::OpenCL, Backend::MPI};
+
+    // Every rank runs the same loop so that MPI candidates see all ranks;
+    // only rank 0's timings are used.
+    auto measure = [&](Operation op, int n, auto&& run) {
+        Backend best = Backend::OpenMP;
+        double bestTime = 0.0;
+        for (Backend backend : backends) {
+            if (!available(backend)) continue;
+
+            double fastest = 0.0;
+            for (int r = 0; r < repetitions; ++r) {
+                MPI_Barrier(comm_);
+                auto start = std::chrono::high_resolution_clock::now();
+                run(backend);
+                auto end = std::chrono::high_resolution_clock::now();
+                std::chrono::duration<double> elapsed = end - start;
+                if (r == 0 || elapsed.count() < fastest) fastest = elapsed.count();
+            }
+
+            if (bestTime == 0.0 || fastest < bestTime) {
+                bestTime = fastest;
+                best = backend;
+            }
+        }
+        if (rank_ == 0) {
+            profile_.set(op, n, best);
+            std::cout << "Calibrated " << operationName(op) << " size: " << n
+                      << ", Backend: " << backendName(best)
+                      << ", Time: " << bestTime << " s" << std::endl;
+        }
+    };
+
+    for (int n : reduceSizes) {
+        std::vector<int> data(rank_ == 0 ? n : 0);
+        for (int& v : data) v = rand() % 10;
+        measure(Operation::Reduce, n, [&](Backend b) { reduceWith(b, data.data(), n); });
+    }
+
+    for (int n : stencilSizes) {
+        size_t total = (rank_ == 0) ? static_cast<size_t>(n) * n : 0;
+        std::vector<double> input(total), output(total);
+        for (double& v : input) v = rand() % 10;
+        measure(Operation::Stencil, n, [&](Backend b) { stencilWith(b, input.data(), output.data(), n, n, 0.01); });
+    }
+
+    for (int n : gemmSizes) {
+        size_t total = (rank_ == 0) ? static_cast<size_t>(n) * n : 0;
+        std::vector<double> A(total), B(total), C(total);
+        for (double& v : A) v = rand() % 10;
+        for (double& v : B) v = rand() % 10;
+        measure(Operation::Gemm, n, [&](Backend b) { gemmWith(b, A.data(), B.data(), C.data(), n); });
+    }
+
+    shareProfile();
+}
+
+// ====Dispatch====
+
+long long DispatchRuntime::reduce(const int* data, int n) {
+    last_ = select(Operation::Reduce, n);
+    return reduceWith(last_, data, n);
+}
+
+void DispatchRuntime::stencil(const double* input, double* output, int rows, int cols, double dx) {
+    // Every backend reads the neighbours j - 1 and j + 1 of a row.
+    if (cols < 2) throw std::invalid_argument("stencil: at least 2 columns are required");
+    last_ = select(Operation::Stencil, std::max(rows, cols));
+    stencilWith(last_, input, output, rows, cols, dx);
+}
+
+void DispatchRuntime::gemm(const double* A, const double* B, double* C, int n) {
+    last_ = select(Operation::Gemm, n);
+    gemmWith(last_, A, B, C, n);
+}
+
+long long DispatchRuntime::reduceWith(Backend backend, const int* data, int n) {
+    if (backend == Backend::MPI) return reduceMPI(data, n);
+    if (rank_ != 0) return 0;
+    return backend == Backend::OpenCL ? reduceOpenCL(data, n) : reduceOpenMP(data, n);
+}
+
+void DispatchRuntime::stencilWith(Backend backend, const double* input, double* output, int rows, int cols, double dx) {
+    if (backend == Backend::MPI) {
+        stencilMPI(input, output, rows, cols, dx);
+    } else if (rank_ == 0) {
+        if (backend == Backend::OpenCL) {
+            stencilOpenCL(input, output, rows, cols, dx);
+        } else {
+            stencilOpenMP(input, output, rows, cols, dx);
+        }
+    }
+}
+
+void DispatchRuntime::gemmWith(Backend backend, const double* A, const double* B, double* C, int n) {
+    if (backend == Backend::MPI) {
+        gemmMPI(A, B, C, n);
+    } else if (rank_ == 0) {
+        if (backend == Backend::OpenCL) {
+            gemmOpenCL(A, B, C, n);
+        } else {
+            gemmOpenMP(A, B, C, n);
+        }
+    }
+}
+
+// ====OpenMP====
+
+long long DispatchRuntime::reduceOpenMP(const int* data, int n) {
+    return kernels::reduceSum(std::span<const int>(data, n));
+}
+
+void DispatchRuntime::stencilOpenMP(const double* input, double* output, int rows, int cols, double dx) {
+    kernels::derivativeX(kernels::MatrixView<const double>::rowMajor(input, rows, cols),
+                         kernels::MatrixView<double>::rowMajor(output, rows, cols), dx);
+}
+
+void DispatchRuntime::gemmOpenMP(const double* A, const double* B, double* C, int n) {
+    kernels::gemm(kernels::MatrixView<const double>::rowMajor(A, n, n),
+                  kernels::MatrixView<const double>::rowMajor(B, n, n),
+                  kernels::MatrixView<double>::rowMajor(C, n, n));
+}
+
+// ====OpenCL====
+
+long long DispatchRuntime::reduceOpenCL(const int* data, int n) {
+    // OpenCL buffers cannot be empty.
+    if (n == 0) return 0;
+    cl_int err;
+    int numGroups = (n + reduceLocalSize_ - 1) / reduceLocalSize_;
+
+    cl_mem inputBuffer = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                        sizeof(int) * n, const_cast<int*>(data), &err);
+    check(err, "clCreateBuffer input");
+    cl_mem partialBuffer = clCreateBuffer(context_, CL_MEM_WRITE_ONLY, sizeof(cl_long) * numGroups, nullptr, &err);
+    check(err, "clCreateBuffer partial");
+
+    check(clSetKernelArg(reduceKernel_, 0, sizeof(cl_mem), &inputBuffer), "set arg 0");
+    check(clSetKernelArg(reduceKernel_, 1, sizeof(cl_mem), &partialBuffer), "set arg 1");
+    check(clSetKernelArg(reduceKernel_, 2, sizeof(int), &n), "set arg 2");
+
+    size_t globalSize = static_cast<size_t>(reduceLocalSize_) * numGroups;
+    size_t local = reduceLocalSize_;
+    check(clEnqueueNDRangeKernel(queue_, reduceKernel_, 1, nullptr, &globalSize, &local, 0, nullptr, nullptr),
+          "enqueue reduce_sum");
+
+    std::vector<cl_long> partialSums(numGroups);
+    check(clEnqueueReadBuffer(queue_, partialBuffer, CL_TRUE, 0, sizeof(cl_long) * numGroups,
+                              partialSums.data(), 0, nullptr, nullptr),
+          "read partial");
+
+    long long total = 0;
+    for (cl_long s : partialSums) total += s;
+
+    clReleaseMemObject(inputBuffer);
+    clReleaseMemObject(partialBuffer);
+    return total;
+}
+
+void DispatchRuntime::stencilOpenCL(const double* input, double* output, int rows, int cols, double dx) {
+    cl_int err;
+    size_t bytes = sizeof(double) * rows * cols;
+
+    cl_mem inputBuffer = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                        bytes, const_cast<double*>(input), &err);
+    check(err, "clCreateBuffer input");
+    cl_mem outputBuffer = clCreateBuffer(context_, CL_MEM_WRITE_ONLY, bytes, nullptr, &err);
+    check(err, "clCreateBuffer output");
+
+    check(clSetKernelArg(stencilKernel_, 0, sizeof(cl_mem), &inputBuffer), "set arg 0");
+    check(clSetKernelArg(stencilKernel_, 1, sizeof(cl_mem), &outputBuffer), "set arg 1");
+    check(clSetKernelArg(stencilKernel_, 2, sizeof(int), &rows), "set arg 2");
+    check(clSetKernelArg(stencilKernel_, 3, sizeof(int), &cols), "set arg 3");
+    check(clSetKernelArg(stencilKernel_, 4, sizeof(double), &dx), "set arg 4");
+
+    size_t globalSize[2] = {static_cast<size_t>(rows), static_cast<size_t>(cols)};
+    check(clEnqueueNDRangeKernel(queue_, stencilKernel_, 2, nullptr, globalSize, nullptr, 0, nullptr, nullptr),
+          "enqueue computeDerivativeX");
+    check(clEnqueueReadBuffer(queue_, outputBuffer, CL_TRUE, 0, bytes, output, 0, nullptr, nullptr), "read output");
+
+    clReleaseMemObject(inputBuffer);
+    clReleaseMemObject(outputBuffer);
+}
+
+void DispatchRuntime::gemmOpenCL(const double* A, const double* B, double* C, int n) {
+    cl_int err;
+    size_t bytes = sizeof(double) * n * n;
+
+    cl_mem bufA = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, const_cast<double*>(A), &err);
+    check(err, "clCreateBuffer A");
+    cl_mem bufB = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, const_cast<double*>(B), &err);
+    check(err, "clCreateBuffer B");
+    cl_mem bufC = clCreateBuffer(context_, CL_MEM_WRITE_ONLY, bytes, nullptr, &err);
+    check(err, "clCreateBuffer C");
+
+    check(clSetKernelArg(gemmKernel_, 0, sizeof(cl_mem), &bufA), "set arg 0");
+    check(clSetKernelArg(gemmKernel_, 1, sizeof(cl_mem), &bufB), "set arg 1");
+    check(clSetKernelArg(gemmKernel_, 2, sizeof(cl_mem), &bufC), "set arg 2");
+    check(clSetKernelArg(gemmKernel_, 3, sizeof(int), &n), "set arg 3");
+
+    size_t padded = roundUp(n, gemmTile);
+    size_t globalSize[2] = {padded, padded};
+    size_t localSize[2] = {gemmTile, gemmTile};
+    check(clEnqueueNDRangeKernel(queue_, gemmKernel_, 2, nullptr, globalSize, localSize, 0, nullptr, nullptr),
+          "enqueue matMulTiled");
+    check(clEnqueueReadBuffer(queue_, bufC, CL_TRUE, 0, bytes, C, 0, nullptr, nullptr), "read C");
+
+    clReleaseMemObject(bufA);
+    clReleaseMemObject(bufB);
+    clReleaseMemObject(bufC);
+}
+
+// ====MPI====
+
+long long DispatchRuntime::reduceMPI(const int* data, int n) {
+    std::vector<int> counts, displs;
+    splitCounts(n, size_, 1, counts, displs);
+
+    std::vector<int> local(counts[rank_]);
+    MPI_Scatterv(data, counts.data(), displs.data(), MPI_INT,
+                 local.data(), counts[rank_], MPI_INT, 0, comm_);
+
+    long long partial = reduceOpenMP(local.data(), counts[rank_]);
+    long long total = 0;
+    MPI_Reduce(&partial, &total, 1, MPI_LONG_LONG, MPI_SUM, 0, comm_);
+    return total;
+}
+
+void DispatchRuntime::stencilMPI(const double* input, double* output, int rows, int cols, double dx) {
+    // The derivative is taken along rows, so row blocks need no halo.
+    std::vector<int> counts, displs;
+    splitCounts(rows, size_, cols, counts, displs);
+    int localRows = counts[rank_] / cols;
+
+    std::vector<double> localIn(counts[rank_]), localOut(counts[rank_]);
+    MPI_Scatterv(input, counts.data(), displs.data(), MPI_DOUBLE,
+                 localIn.data(), counts[rank_], MPI_DOUBLE, 0, comm_);
+
+    if (localRows > 0) stencilOpenMP(localIn.data(), localOut.data(), localRows, cols, dx);
+
+    MPI_Gatherv(localOut.data(), counts[rank_], MPI_DOUBLE,
+                output, counts.data(), displs.data(), MPI_DOUBLE, 0, comm_);
+}
+
+void DispatchRuntime::gemmMPI(const double* A, const double* B, double* C, int n) {
+    std::vector<int> counts, displs;
+    splitCounts(n, size_, n, counts, displs);
+    int localRows = counts[rank_] / n;
+
+    std::vector<double> localA(counts[rank_]), localC(counts[rank_]);
+    std::vector<double> fullB;
+    const double* b = B;
+    if (rank_ != 0) {
+        fullB.resize(static_cast<size_t>(n) * n);
+        b = fullB.data();
+    }
+
+    MPI_Scatterv(A, counts.data(), displs.data(), MPI_DOUBLE,
+                 localA.data(), counts[rank_], MPI_DOUBLE, 0, comm_);
+    MPI_Bcast(const_cast<double*>(b), n * n, MPI_DOUBLE, 0, comm_);
+
+    // Rows of C are independent, so each rank runs the shared-memory kernel
+    // on its own block.
+    if (localRows > 0) {
+        kernels::gemm(kernels::MatrixView<const double>::rowMajor(localA.data(), localRows, n),
+                      kernels::MatrixView<const double>::rowMajor(b, n, n),
+                      kernels::MatrixView<double>::rowMajor(localC.data(), localRows, n));
+    }
+
+    MPI_Gatherv(localC.data(), counts[rank_], MPI_DOUBLE,
+                C, counts.data(), displs.data(), MPI_DOUBLE, 0, comm_);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#define CL_TARGET_OPENCL_VERSION 300
+#include <CL/cl.h>
+#include <mpi.h>
+
+#include <string>
+#include <vector>
+
+// Backends a call can be routed to. MPI means "split the work across the
+// communicator the runtime was created with".
+enum class Backend { OpenMP, OpenCL, MPI };
+
+enum class Operation { Reduce, Stencil, Gemm };
+
+const char* backendName(Backend backend);
+const char* operationName(Operation op);
+
+// Result of a calibration pass: for every operation, the fastest backend
+// measured at a ladder of problem sizes. A call of size n uses the entry with
+// the largest calibrated size <= n (or the smallest entry if n is below all).
+class DispatchProfile {
+public:
+    struct Entry {
+        long size;
+        Backend backend;
+    };
+
+    void set(Operation op, long size, Backend backend);
+    Backend select(Operation op, long size) const;
+    bool empty() const;
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    std::string serialize() const;
+    bool parse(const std::string& text);
+
+private:
+    std::vector<Entry> entries[3];
+};
+
+// Single entry point for reduce, stencil and GEMM. All calls are collective
+// over the communicator: every rank calls with the same sizes, input is read
+// on rank 0 only and results are valid on rank 0 only.
+class DispatchRuntime {
+public:
+    explicit DispatchRuntime(MPI_Comm comm);
+    ~DispatchRuntime();
+
+    DispatchRuntime(const DispatchRuntime&) = delete;
+    DispatchRuntime& operator=(const DispatchRuntime&) = delete;
+
+    // Measures every available backend at a ladder of sizes and stores the
+    // crossover points in the profile. Collective.
+    void calibrate();
+
+    // Rank 0 reads the profile and shares it with the other ranks. Collective.
+    bool loadProfile(const std::string& path);
+    bool saveProfile(const std::string& path) const;
+
+    const DispatchProfile& profile() const { return profile_; }
+    bool available(Backend backend) const;
+    Backend select(Operation op, long size) const;
+
+    // Sum of n ints.
+    long long reduce(const int* data, int n);
+    // Central-difference d/dx along each row of a rows x cols row-major grid;
+    // throws std::invalid_argument for fewer than 2 columns.
+    void stencil(const double* input, double* output, int rows, int cols, double dx);
+    // C = A * B for n x n row-major matrices.
+    void gemm(const double* A, const double* B, double* C, int n);
+
+    Backend lastBackend() const { return last_; }
+    int rank() const { return rank_; }
+
+private:
+    long long reduceWith(Backend backend, const int* data, int n);
+    void stencilWith(Backend backend, const double* input, double* output, int rows, int cols, double dx);
+    void gemmWith(Backend backend, const double* A, const double* B, double* C, int n);
+
+    long long reduceOpenMP(const int* data, int n);
+    long long reduceOpenCL(const int* data, int n);
+    long long reduceMPI(const int* data, int n);
+
+    void stencilOpenMP(const double* input, double* output, int rows, int cols, double dx);
+    void stencilOpenCL(const double* input, double* output, int rows, int cols, double dx);
+    void stencilMPI(const double* input, double* output, int rows, int cols, double dx);
+
+    void gemmOpenMP(const double* A, const double* B, double* C, int n);
+    void gemmOpenCL(const double* A, const double* B, double* C, int n);
+    void gemmMPI(const double* A, const double* B, double* C, int n);
+
+    bool initOpenCL();
+    void releaseOpenCL();
+    void shareProfile();
+
+    MPI_Comm comm_;
+    int rank_ = 0;
+    int size_ = 1;
+
+    DispatchProfile profile_;
+    Backend last_ = Backend::OpenMP;
+
+    bool clReady_ = false;
+    cl_device_id device_ = nullptr;
+    cl_context context_ = nullptr;
+    cl_command_queue queue_ = nullptr;
+    cl_program program_ = nullptr;
+    cl_kernel reduceKernel_ = nullptr;
+    cl_kernel stencilKernel_ = nullptr;
+    cl_kernel gemmKernel_ = nullptr;
+    // Work-group size reduce_sum was built for.
+    int reduceLocalSize_ = 0;
+};
@@ -1,8 +1,562 @@
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include "mpi.h"
 
+// MPI microbenchmarks behind --bench. Every part prints a curve as CSV under a
+// "#" header, followed by "#" summary lines, so that the output of one run can
+// be redirected to a file and plotted:
+//   pingpong     ping-pong latency and windowed streaming bandwidth, ranks 0-1
+//   collectives  Send/Recv loops against Scatterv, Bcast, Reduce, Allreduce
+//   nonblocking  blocking against non-blocking pairwise exchange and overlap
+//   protocol     time a late MPI_Recv takes once posted, which separates
+//                eager from rendezvous sizes, and the limits reported by MPI_T
+
+const size_t defaultMaxBytes = 4 << 20;
+const int streamWindow = 64;
+const double lateReceive = 1e-3;
+const int protocolTrials = 16;
+// Smallest jump of the late receive time between neighbouring sizes that is
+// taken as the switch to rendezvous.
+const double rendezvousJump = 2.5;
+
+// Enough repetitions for small messages to time reliably, few for large ones.
+int repetitions(size_t bytes)
+{
+	size_t reps = (size_t(64) << 20) / std::max<size_t>(bytes, 1);
+	return (int)std::min<size_t>(std::max<size_t>(reps, 10), 1000);
+}
+
+double maxOverRanks(double local)
+{
+	double result;
+	MPI_Allreduce(&local, &result, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+	return result;
+}
+
+// Spins without calling MPI, so no progress is made on pending requests.
+void busyWait(double seconds)
+{
+	double end = MPI_Wtime() + seconds;
+	while (MPI_Wtime() < end)
+	{
+	}
+}
+
+// A barrier on MPI_COMM_WORLD that sleeps between tests instead of polling.
+void sleepingBarrier()
+{
+	MPI_Request request;
+	MPI_Ibarrier(MPI_COMM_WORLD, &request);
+	int done = 0;
+	while (MPI_Test(&request, &done, MPI_STATUS_IGNORE) == MPI_SUCCESS && !done)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+// MPI_Wtime may count from a per-process origin; the steady clock is shared by
+// all processes of a node.
+double nodeTime()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Average time of one call of op, slowest rank; one untimed call first.
+template <typename Op>
+double timeOp(int reps, Op op)
+{
+	MPI_Barrier(MPI_COMM_WORLD);
+	op();
+	MPI_Barrier(MPI_COMM_WORLD);
+	double start = MPI_Wtime();
+	for (int r = 0; r < reps; r++)
+	{
+		op();
+	}
+	return maxOverRanks((MPI_Wtime() - start) / reps);
+}
+
+// ====Ping-pong====
+
+void pingPong(int rank, int size, size_t maxBytes)
+{
+	if (size < 2)
+	{
+		if (rank == 0) printf("# ping-pong needs at least 2 processes\n");
+		return;
+	}
+
+	std::vector<char> buffer(maxBytes);
+	std::vector<MPI_Request> requests(streamWindow);
+	double bestBandwidth = 0.0, smallLatency = 0.0;
+	size_t halfBandwidthBytes = 0;
+	std::vector<double> bandwidths;
+	std::vector<size_t> sizes;
+
+	if (rank == 0)
+	{
+		printf("# ping-pong between ranks 0 and 1\n");
+		printf("bytes,latency_us,pingpong_MB/s,stream_MB/s\n");
+	}
+
+	for (size_t bytes = 1; bytes <= maxBytes; bytes *= 2)
+	{
+		int reps = repetitions(bytes);
+
+		double latency = timeOp(reps, [&] {
+			if (rank == 0)
+			{
+				MPI_Send(buffer.data(), (int)bytes, MPI_BYTE, 1, 0, MPI_COMM_WORLD);
+				MPI_Recv(buffer.data(), (int)bytes, MPI_BYTE, 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			}
+			else if (rank == 1)
+			{
+				MPI_Recv(buffer.data(), (int)bytes, MPI_BYTE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				MPI_Send(buffer.data(), (int)bytes, MPI_BYTE, 0, 0, MPI_COMM_WORLD);
+			}
+		}) / 2;
+
+		// A window of messages in flight, acknowledged once, as in osu_bw.
+		int streamReps = std::max(2, reps / 16);
+		double window = timeOp(streamReps, [&] {
+			if (rank == 0)
+			{
+				for (int w = 0; w < streamWindow; w++)
+					MPI_Isend(buffer.data(), (int)bytes, MPI_BYTE, 1, 1, MPI_COMM_WORLD, &requests[w]);
+				MPI_Waitall(streamWindow, requests.data(), MPI_STATUSES_IGNORE);
+				MPI_Recv(nullptr, 0, MPI_BYTE, 1, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			}
+			else if (rank == 1)
+			{
+				for (int w = 0; w < streamWindow; w++)
+					MPI_Irecv(buffer.data(), (int)bytes, MPI_BYTE, 0, 1, MPI_COMM_WORLD, &requests[w]);
+				MPI_Waitall(streamWindow, requests.data(), MPI_STATUSES_IGNORE);
+				MPI_Send(nullptr, 0, MPI_BYTE, 0, 2, MPI_COMM_WORLD);
+			}
+		});
+
+		double pingPongBandwidth = bytes / latency / 1e6;
+		double streamBandwidth = streamWindow * bytes / window / 1e6;
+		if (bytes == 1) smallLatency = latency;
+		bestBandwidth = std::max(bestBandwidth, streamBandwidth);
+		sizes.push_back(bytes);
+		bandwidths.push_back(streamBandwidth);
+
+		if (rank == 0)
+		{
+			printf("%zu,%.3f,%.1f,%.1f\n", bytes, latency * 1e6, pingPongBandwidth, streamBandwidth);
+		}
+	}
+
+	for (size_t i = 0; i < sizes.size(); i++)
+	{
+		if (bandwidths[i] >= bestBandwidth / 2)
+		{
+			halfBandwidthBytes = sizes[i];
+			break;
+		}
+	}
+
+	if (rank == 0)
+	{
+		printf("# latency: %.3f us, peak stream bandwidth: %.1f MB/s, half of it reached at %zu bytes\n",
+		       smallLatency * 1e6, bestBandwidth, halfBandwidthBytes);
+	}
+}
+
+// ====Collectives====
+
+// Returns the first size from which the collective stays faster than the loop.
+size_t crossover(const std::vector<size_t>& sizes, const std::vector<double>& loop, const std::vector<double>& collective)
+{
+	size_t from = 0;
+	for (size_t i = sizes.size(); i-- > 0;)
+	{
+		if (collective[i] >= loop[i]) break;
+		from = sizes[i];
+	}
+	return from;
+}
+
+void printCrossover(const char* name, const char* loopName, size_t from)
+{
+	if (from == 0)
+		printf("# %s: %s is faster at the largest size\n", name, loopName);
+	else
+		printf("# %s: collective faster than %s from %zu bytes\n", name, loopName, from);
+}
+
+void collectives(int rank, int size, size_t maxBytes)
+{
+	size_t maxCount = std::max<size_t>(maxBytes / sizeof(double), 1);
+	std::vector<double> data(maxCount, 1.0), result(maxCount), incoming(maxCount);
+	std::vector<int> counts(size), displs(size);
+
+	std::vector<size_t> sizes;
+	std::vector<double> scatterLoop, scatterv, bcastLoop, bcast, reduceLoop, reduce, reduceBcast, allreduce;
+
+	if (rank == 0)
+	{
+		printf("# root 0 distributes or collects a total of `bytes` (Scatterv) or `bytes` per rank (others), %d processes\n", size);
+		printf("bytes,scatter_loop_us,scatterv_us,bcast_loop_us,bcast_us,reduce_loop_us,reduce_us,reduce_bcast_us,allreduce_us\n");
+	}
+
+	for (size_t count = 1; count <= maxCount; count *= 4)
+	{
+		int n = (int)count;
+		int reps = repetitions(count * sizeof(double));
+		for (int r = 0, offset = 0; r < size; r++)
+		{
+			counts[r] = n / size + (r < n % size ? 1 : 0);
+			displs[r] = offset;
+			offset += counts[r];
+		}
+
+		double tScatterLoop = timeOp(reps, [&] {
+			if (rank == 0)
+			{
+				for (int r = 1; r < size; r++)
+					MPI_Send(data.data() + displs[r], counts[r], MPI_DOUBLE, r, 0, MPI_COMM_WORLD);
+			}
+			else
+			{
+				MPI_Recv(result.data(), counts[rank], MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			}
+		});
+		double tScatterv = timeOp(reps, [&] {
+			MPI_Scatterv(data.data(), counts.data(), displs.data(), MPI_DOUBLE,
+			             result.data(), counts[rank], MPI_DOUBLE, 0, MPI_COMM_WORLD);
+		});
+
+		double tBcastLoop = timeOp(reps, [&] {
+			if (rank == 0)
+			{
+				for (int r = 1; r < size; r++)
+					MPI_Send(data.data(), n, MPI_DOUBLE, r, 0, MPI_COMM_WORLD);
+			}
+			else
+			{
+				MPI_Recv(data.data(), n, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			}
+		});
+		double tBcast = timeOp(reps, [&] { MPI_Bcast(data.data(), n, MPI_DOUBLE, 0, MPI_COMM_WORLD); });
+
+		double tReduceLoop = timeOp(reps, [&] {
+			if (rank == 0)
+			{
+				std::copy(data.begin(), data.begin() + n, result.begin());
+				for (int r = 1; r < size; r++)
+				{
+					MPI_Recv(incoming.data(), n, MPI_DOUBLE, r, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+					for (int i = 0; i < n; i++) result[i] += incoming[i];
+				}
+			}
+			else
+			{
+				MPI_Send(data.data(), n, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
+			}
+		});
+		double tReduce = timeOp(reps, [&] {
+			MPI_Reduce(data.data(), result.data(), n, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+		});
+
+		double tReduceBcast = timeOp(reps, [&] {
+			MPI_Reduce(data.data(), result.data(), n, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+			MPI_Bcast(result.data(), n, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+		});
+		double tAllreduce = timeOp(reps, [&] {
+			MPI_Allreduce(data.data(), result.data(), n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+		});
+
+		sizes.push_back(count * sizeof(double));
+		scatterLoop.push_back(tScatterLoop);
+		scatterv.push_back(tScatterv);
+		bcastLoop.push_back(tBcastLoop);
+		bcast.push_back(tBcast);
+		reduceLoop.push_back(tReduceLoop);
+		reduce.push_back(tReduce);
+		reduceBcast.push_back(tReduceBcast);
+		allreduce.push_back(tAllreduce);
+
+		if (rank == 0)
+		{
+			printf("%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", count * sizeof(double),
+			       tScatterLoop * 1e6, tScatterv * 1e6, tBcastLoop * 1e6, tBcast * 1e6,
+			       tReduceLoop * 1e6, tReduce * 1e6, tReduceBcast * 1e6, tAllreduce * 1e6);
+		}
+	}
+
+	if (rank == 0)
+	{
+		printCrossover("Scatterv", "Send loop", crossover(sizes, scatterLoop, scatterv));
+		printCrossover("Bcast", "Send loop", crossover(sizes, bcastLoop, bcast));
+		printCrossover("Reduce", "Recv loop", crossover(sizes, reduceLoop, reduce));
+		printCrossover("Allreduce", "Reduce + Bcast", crossover(sizes, reduceBcast, allreduce));
+	}
+}
+
+// ====Blocking against non-blocking====
+
+void nonBlocking(int rank, int size, size_t maxBytes)
+{
+	if (size < 2)
+	{
+		if (rank == 0) printf("# non-blocking exchange needs at least 2 processes\n");
+		return;
+	}
+
+	// Ranks exchange with rank ^ 1; an odd rank out idles.
+	int partner = rank ^ 1;
+	bool paired = partner < size;
+	std::vector<char> sendBuffer(maxBytes), recvBuffer(maxBytes);
+	MPI_Request requests[2];
+
+	if (rank == 0)
+	{
+		printf("# pairwise exchange (rank <-> rank ^ 1), overlap with a compute phase as long as the exchange\n");
+		printf("bytes,blocking_us,nonblocking_us,overlap_%%\n");
+	}
+
+	for (size_t bytes = 1; bytes <= maxBytes; bytes *= 4)
+	{
+		int reps = repetitions(bytes);
+		int n = (int)bytes;
+
+		double tBlocking = timeOp(reps, [&] {
+			if (!paired) return;
+			if (rank % 2 == 0)
+			{
+				MPI_Send(sendBuffer.data(), n, MPI_BYTE, partner, 0, MPI_COMM_WORLD);
+				MPI_Recv(recvBuffer.data(), n, MPI_BYTE, partner, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			}
+			else
+			{
+				MPI_Recv(recvBuffer.data(), n, MPI_BYTE, partner, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				MPI_Send(sendBuffer.data(), n, MPI_BYTE, partner, 0, MPI_COMM_WORLD);
+			}
+		});
+
+		auto exchangeStart = [&] {
+			MPI_Irecv(recvBuffer.data(), n, MPI_BYTE, partner, 0, MPI_COMM_WORLD, &requests[0]);
+			MPI_Isend(sendBuffer.data(), n, MPI_BYTE, partner, 0, MPI_COMM_WORLD, &requests[1]);
+		};
+
+		double tNonBlocking = timeOp(reps, [&] {
+			if (!paired) return;
+			exchangeStart();
+			MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+		});
+
+		// 100% means the transfer was hidden completely behind the computation.
+		double compute = tNonBlocking;
+		double tOverlapped = timeOp(std::max(reps / 4, 5), [&] {
+			if (!paired) return;
+			exchangeStart();
+			busyWait(compute);
+			MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+		});
+		double overlap = (tNonBlocking + compute - tOverlapped) / std::min(tNonBlocking, compute);
+		overlap = std::min(std::max(overlap, 0.0), 1.0);
+
+		if (rank == 0)
+		{
+			printf("%zu,%.3f,%.3f,%.0f\n", bytes, tBlocking * 1e6, tNonBlocking * 1e6, overlap * 100);
+		}
+	}
+}
+
+// ====Eager against rendezvous====
+
+// Median of a short sample.
+double median(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	return values[values.size() / 2];
+}
+
+// The eager limits the library reports through the MPI tool interface, e.g.
+// btl_vader_eager_limit in Open MPI, as a cross-check of the measured one.
+void printEagerLimitCvars()
+{
+	int provided, count;
+	if (MPI_T_init_thread(MPI_THREAD_SINGLE, &provided) != MPI_SUCCESS) return;
+	MPI_T_cvar_get_num(&count);
+	for (int index = 0; index < count; index++)
+	{
+		char name[256];
+		int nameLength = sizeof(name), descriptionLength = 0, verbosity, binding, scope;
+		MPI_Datatype datatype;
+		MPI_T_enum enumType;
+		if (MPI_T_cvar_get_info(index, name, &nameLength, &verbosity, &datatype, &enumType,
+				nullptr, &descriptionLength, &binding, &scope) != MPI_SUCCESS)
+			continue;
+		if (!strstr(name, "eager_limit") || binding != MPI_T_BIND_NO_OBJECT) continue;
+
+		MPI_T_cvar_handle handle;
+		int elements;
+		if (MPI_T_cvar_handle_alloc(index, nullptr, &handle, &elements) != MPI_SUCCESS) continue;
+		if (elements == 1)
+		{
+			unsigned long long value = 0;
+			if (datatype == MPI_INT || datatype == MPI_UNSIGNED)
+			{
+				unsigned int v;
+				MPI_T_cvar_read(handle, &v);
+				value = v;
+			}
+			else if (datatype == MPI_UNSIGNED_LONG || datatype == MPI_COUNT)
+			{
+				unsigned long v;
+				MPI_T_cvar_read(handle, &v);
+				value = v;
+			}
+			else if (datatype == MPI_UNSIGNED_LONG_LONG)
+			{
+				MPI_T_cvar_read(handle, &value);
+			}
+			else
+			{
+				MPI_T_cvar_handle_free(&handle);
+				continue;
+			}
+			printf("# MPI_T %s: %llu bytes\n", name, value);
+		}
+		MPI_T_cvar_handle_free(&handle);
+	}
+	MPI_T_finalize();
+}
+
+void protocol(int rank, int size, size_t maxBytes)
+{
+	if (size < 2)
+	{
+		if (rank == 0) printf("# protocol detection needs at least 2 processes\n");
+		return;
+	}
+
+	// Only ranks 0 and 1 take part; the others wait without polling so that
+	// they do not take the CPU from them on an oversubscribed node.
+	MPI_Comm pair;
+	MPI_Comm_split(MPI_COMM_WORLD, rank < 2 ? 0 : MPI_UNDEFINED, rank, &pair);
+	if (pair == MPI_COMM_NULL)
+	{
+		sleepingBarrier();
+		return;
+	}
+
+	std::vector<char> buffer(maxBytes), copy(maxBytes);
+	// Median late receive and memcpy per size; no receive time when no trial
+	// was informative.
+	std::vector<size_t> sizes;
+	std::vector<double> receiveTimes, copyTimes;
+
+	for (size_t bytes = 1; bytes <= maxBytes; bytes *= 2)
+	{
+		// An eager message is already in the receiver's queue when the late
+		// receive is posted, so the receive costs a match and a copy. A
+		// rendezvous receive first has to reach the sender (a request to send
+		// and a get or a clear-to-send), and the sender does not call MPI while
+		// it sleeps. Only trials in which the send started well before the post
+		// count, since oversubscribed ranks may be descheduled for most of the
+		// delay. Comparing instants needs ranks 0 and 1 on one node.
+		std::vector<double> receives;
+		int informative = 0;
+		for (int trial = 0; trial < 4 * protocolTrials && informative < protocolTrials; trial++)
+		{
+			MPI_Barrier(pair);
+			if (rank == 0)
+			{
+				MPI_Request request;
+				MPI_Isend(buffer.data(), (int)bytes, MPI_BYTE, 1, 0, pair, &request);
+				double sent = nodeTime();
+				std::this_thread::sleep_for(std::chrono::duration<double>(2 * lateReceive));
+				MPI_Wait(&request, MPI_STATUS_IGNORE);
+
+				double received[2];
+				MPI_Recv(received, 2, MPI_DOUBLE, 1, 1, pair, MPI_STATUS_IGNORE);
+				if (received[0] - sent >= lateReceive / 2) receives.push_back(received[1]);
+			}
+			else if (rank == 1)
+			{
+				// Sleeping rather than spinning leaves the CPU to the other ranks.
+				std::this_thread::sleep_for(std::chrono::duration<double>(lateReceive));
+				double posted = nodeTime();
+				MPI_Recv(buffer.data(), (int)bytes, MPI_BYTE, 0, 0, pair, MPI_STATUS_IGNORE);
+				double received[2] = {posted, nodeTime() - posted};
+				MPI_Send(received, 2, MPI_DOUBLE, 0, 1, pair);
+			}
+			informative = (int)receives.size();
+			MPI_Bcast(&informative, 1, MPI_INT, 0, pair);
+		}
+
+		if (rank != 0) continue;
+
+		std::vector<double> copies;
+		for (int trial = 0; trial < protocolTrials; trial++)
+		{
+			double start = nodeTime();
+			memcpy(copy.data(), buffer.data(), bytes);
+			copies.push_back(nodeTime() - start);
+		}
+
+		sizes.push_back(bytes);
+		receiveTimes.push_back(receives.empty() ? -1.0 : median(receives));
+		copyTimes.push_back(median(copies));
+	}
+
+	if (rank == 0)
+	{
+		// The protocol switches once, where the receive time beyond the copy
+		// jumps by the handshake. Eager receives already vary by a factor of
+		// two or so with the transport's internal paths (e.g. Open MPI vader
+		// fast boxes), so the switch is the largest jump between neighbouring
+		// sizes, if it is at least rendezvousJump.
+		size_t firstRendezvous = sizes.size();
+		double largestJump = rendezvousJump;
+		double previous = -1.0;
+		for (size_t i = 0; i < sizes.size(); i++)
+		{
+			if (receiveTimes[i] < 0) continue;
+			double excess = std::max(receiveTimes[i] - copyTimes[i], 1e-9);
+			if (previous > 0 && excess / previous >= largestJump)
+			{
+				largestJump = excess / previous;
+				firstRendezvous = i;
+			}
+			previous = excess;
+		}
+
+		printf("# MPI_Recv time on rank 1 when posted %.0f us after rank 0 started the send,"
+			" against a memcpy of the message\n", lateReceive * 1e6);
+		printf("bytes,late_recv_us,memcpy_us,protocol\n");
+		for (size_t i = 0; i < sizes.size(); i++)
+		{
+			if (receiveTimes[i] < 0)
+				printf("%zu,,%.3f,unknown\n", sizes[i], copyTimes[i] * 1e6);
+			else
+				printf("%zu,%.3f,%.3f,%s\n", sizes[i], receiveTimes[i] * 1e6, copyTimes[i] * 1e6,
+					i < firstRendezvous ? "eager" : "rendezvous");
+		}
+
+		if (firstRendezvous == sizes.size())
+			printf("# eager limit: above %zu bytes, no rendezvous in the sweep\n", maxBytes);
+		else
+			printf("# eager limit: %zu bytes (largest eager size of the sweep); larger messages need a"
+				" handshake with the sender\n", sizes[firstRendezvous - 1]);
+		printEagerLimitCvars();
+	}
+	MPI_Comm_free(&pair);
+	sleepingBarrier();
+}
+
 int main(int argc, char **argv)
-{	
+{
 	const int MAX = 3;
 	int rank, size;
 
@@ -10,12 +564,46 @@ int main(int argc, char **argv)
 	MPI_Comm_size(MPI_COMM_WORLD, &size);
 	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+	{
+		const char* part = argc > 2 ? argv[2] : "all";
+		bool all = strcmp(part, "all") == 0;
+		bool known = all || strcmp(part, "pingpong") == 0 || strcmp(part, "collectives") == 0 ||
+			strcmp(part, "nonblocking") == 0 || strcmp(part, "protocol") == 0;
+
+		// Message sizes are passed to MPI as int counts of bytes.
+		size_t maxBytes = defaultMaxBytes;
+		if (argc > 3)
+		{
+			char *end;
+			unsigned long long value = strtoull(argv[3], &end, 10);
+			maxBytes = (*end == '\0' && argv[3][0] != '-' && value >= 1 && value <= INT_MAX) ? value : 0;
+		}
+
+		if (!known || maxBytes == 0 || argc > 4)
+		{
+			if (rank == 0)
+				fprintf(stderr, "Usage: %s --bench [pingpong|collectives|nonblocking|protocol|all] [max bytes, 1 to %d]\n",
+					argv[0], INT_MAX);
+			MPI_Finalize();
+			return 1;
+		}
+
+		if (all || strcmp(part, "pingpong") == 0) pingPong(rank, size, maxBytes);
+		if (all || strcmp(part, "collectives") == 0) collectives(rank, size, maxBytes);
+		if (all || strcmp(part, "nonblocking") == 0) nonBlocking(rank, size, maxBytes);
+		if (all || strcmp(part, "protocol") == 0) protocol(rank, size, maxBytes);
+
+		MPI_Finalize();
+		return 0;
+	}
+
 	for(int i = 0; i < MAX; i++)
 	{
 		printf("Message from process: %d, size: %d\n", rank, size);
 	}
 
 	MPI_Finalize();
-	
+
 	return 0;
-}
\ No newline at end of file
+}
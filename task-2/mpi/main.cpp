@@ -1,9 +1,32 @@
 #include <mpi.h>
+
+#include "kernels/perf.hpp"
+#include "kernels/reprosum.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 #include <chrono>
 
+// Window of the mapped file a rank sums before releasing it. Each rank keeps
+// at most the current and the prefetched window resident.
+constexpr size_t streamWindowBytes = 8 << 20;
+
 void fillRandom(int* data, int size) {
     for (int i = 0; i < size; ++i) {
         data[i] = rand() % 10;
@@ -18,6 +41,241 @@ int computeSum(const int* data, int size) {
     return total;
 }
 
+int openInput(const char* path, size_t& bytes) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        perror(path);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    bytes = info.st_size;
+    return fd;
+}
+
+// Plain single-process read() of the whole file after evicting it from the
+// page cache: the disk's sequential bandwidth the stream is compared to.
+double measureSequentialRead(const char* path) {
+    size_t bytes;
+    int fd = openInput(path, bytes);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<char> buffer(streamWindowBytes);
+    double timeStart = MPI_Wtime();
+    while (read(fd, buffer.data(), buffer.size()) > 0) {
+    }
+    double timeEnd = MPI_Wtime();
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    return bytes / (timeEnd - timeStart) / 1e9;
+}
+
+// Every rank maps only its own slice of the file and sums it window by window,
+// prefetching the next window and dropping the consumed one.
+void streamSum(const char* path, int rank, int size) {
+    double rawBandwidth = 0.0;
+    if (rank == 0) rawBandwidth = measureSequentialRead(path);
+
+    size_t bytes;
+    int fd = openInput(path, bytes);
+    size_t count = bytes / sizeof(int);
+
+    size_t begin = count * rank / size;
+    size_t end = count * (rank + 1) / size;
+
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t mapOffset = (begin * sizeof(int)) & ~(pageSize - 1);
+    size_t mapBytes = end * sizeof(int) - mapOffset;
+
+    const int* data = nullptr;
+    void* mapping = nullptr;
+    if (mapBytes > 0) {
+        mapping = mmap(nullptr, mapBytes, PROT_READ, MAP_SHARED, fd, mapOffset);
+        if (mapping == MAP_FAILED) {
+            perror("mmap");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        madvise(mapping, mapBytes, MADV_SEQUENTIAL);
+        data = reinterpret_cast<const int*>(static_cast<const char*>(mapping) - mapOffset);
+    }
+
+    // Page-aligned byte range of elements [from, to).
+    auto pages = [&](size_t from, size_t to, char*& first, size_t& length) {
+        uintptr_t lo = reinterpret_cast<uintptr_t>(data + from) & ~(pageSize - 1);
+        uintptr_t hi = reinterpret_cast<uintptr_t>(data + to);
+        first = reinterpret_cast<char*>(lo);
+        length = hi - lo;
+    };
+
+    const size_t windowElems = streamWindowBytes / sizeof(int);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double timeStart = MPI_Wtime();
+
+    long long partialSum = 0;
+    for (size_t window = begin; window < end; window += windowElems) {
+        size_t windowEnd = std::min(window + windowElems, end);
+
+        if (windowEnd < end) {
+            char* first;
+            size_t length;
+            pages(windowEnd, std::min(windowEnd + windowElems, end), first, length);
+            madvise(first, length, MADV_WILLNEED);
+        }
+
+        for (size_t i = window; i < windowEnd; ++i) {
+            partialSum += data[i];
+        }
+
+        char* first;
+        size_t length;
+        pages(window, windowEnd, first, length);
+        madvise(first, length, MADV_DONTNEED);
+    }
+
+    long long totalSum = 0;
+    MPI_Reduce(&partialSum, &totalSum, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    double timeEnd = MPI_Wtime();
+
+    if (mapping) munmap(mapping, mapBytes);
+    posix_fadvise(fd, mapOffset, mapBytes, POSIX_FADV_DONTNEED);
+    close(fd);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long peakRss = usage.ru_maxrss, maxPeakRss = 0;
+    MPI_Reduce(&peakRss, &maxPeakRss, 1, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        double elapsed = timeEnd - timeStart;
+        double bandwidth = bytes / elapsed / 1e9;
+        std::cout << "Stream file: " << path
+                  << ", Elements: " << count
+                  << ", Total sum: " << totalSum
+                  << ", Time: " << elapsed << " s"
+                  << ", Throughput: " << bandwidth << " GB/s"
+                  << ", Raw sequential read: " << rawBandwidth << " GB/s"
+                  << " (" << 100.0 * bandwidth / rawBandwidth << "%)"
+                  << ", Peak RSS per rank: " << maxPeakRss / 1024 << " MiB" << std::endl;
+    }
+}
+
+// MPI_Op merging binned accumulators. Merges are exact, so the op is
+// commutative and the reduction tree MPI picks does not change the bits.
+void reproMergeOp(void* in, void* inout, int* len, MPI_Datatype*) {
+    auto* from = static_cast<const kernels::ReproAccumulator*>(in);
+    auto* into = static_cast<kernels::ReproAccumulator*>(inout);
+    for (int i = 0; i < *len; ++i) {
+        kernels::reproMerge(into[i], from[i]);
+    }
+}
+
+MPI_Datatype createReproType() {
+    // top and scaled are adjacent ints.
+    int blockLengths[3] = {2, REPRO_FOLDS, 1};
+    MPI_Aint displacements[3] = {offsetof(kernels::ReproAccumulator, top),
+                                 offsetof(kernels::ReproAccumulator, fold),
+                                 offsetof(kernels::ReproAccumulator, special)};
+    MPI_Datatype types[3] = {MPI_INT, MPI_DOUBLE, MPI_DOUBLE};
+
+    MPI_Datatype structType, reproType;
+    MPI_Type_create_struct(3, blockLengths, displacements, types, &structType);
+    MPI_Type_create_resized(structType, 0, sizeof(kernels::ReproAccumulator), &reproType);
+    MPI_Type_commit(&reproType);
+    MPI_Type_free(&structType);
+    return reproType;
+}
+
+// Inputs of the --fp checks: values spread over several magnitudes, the same
+// with one NaN in the middle, or with every eighth value near 2^1000, above
+// the highest bin with a finite boundary.
+enum class FpInput { Spread, OneNaN, Huge };
+
+const char* fpInputLabel(FpInput input) {
+    switch (input) {
+        case FpInput::OneNaN: return " (one NaN)";
+        case FpInput::Huge: return " (values near 2^1000)";
+        default: return "";
+    }
+}
+
+// Sums doubles spread over several magnitudes twice: with MPI_SUM over plain
+// partial sums and with the binned accumulator and a custom MPI_Op. Rank 0
+// also sums the whole array alone; the reproducible result must match it bit
+// for bit whatever the number of ranks. With a NaN both sums must be NaN.
+void compareFloatingSums(int rank, int size) {
+    MPI_Datatype reproType = createReproType();
+    MPI_Op reproOp;
+    MPI_Op_create(reproMergeOp, 1, &reproOp);
+
+    std::vector<std::pair<int, FpInput>> testCases = {
+        {10, FpInput::Spread}, {1000, FpInput::Spread}, {10000000, FpInput::Spread},
+        {1000, FpInput::OneNaN}, {100000, FpInput::Huge}};
+
+    for (auto [currSize, input] : testCases) {
+        bool withNaN = input == FpInput::OneNaN;
+        std::vector<double> fullData;
+        if (rank == 0) {
+            fullData.resize(currSize);
+            for (int i = 0; i < currSize; ++i) {
+                double x = (rand() / static_cast<double>(RAND_MAX) - 0.5) * std::pow(10.0, rand() % 8);
+                fullData[i] = input == FpInput::Huge && i % 8 == 0 ? std::ldexp(x, 990) : x;
+            }
+            if (withNaN) fullData[currSize / 2] = std::numeric_limits<double>::quiet_NaN();
+        }
+
+        std::vector<int> counts(size), displs(size);
+        for (int i = 0, offset = 0; i < size; ++i) {
+            counts[i] = currSize / size + (i < currSize % size ? 1 : 0);
+            displs[i] = offset;
+            offset += counts[i];
+        }
+        std::vector<double> localData(counts[rank]);
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        double plainStart = MPI_Wtime();
+        MPI_Scatterv(fullData.data(), counts.data(), displs.data(), MPI_DOUBLE,
+                     localData.data(), counts[rank], MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        double partialSum = 0.0;
+        for (double x : localData) partialSum += x;
+        double plainSum = 0.0;
+        MPI_Reduce(&partialSum, &plainSum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        double plainTime = MPI_Wtime() - plainStart;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        double reproStart = MPI_Wtime();
+        MPI_Scatterv(fullData.data(), counts.data(), displs.data(), MPI_DOUBLE,
+                     localData.data(), counts[rank], MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        const kernels::ReproParams params = kernels::reproParams(currSize);
+        kernels::ReproAccumulator partial = kernels::reproEmpty();
+        kernels::reproAccumulate(params, localData.data(), localData.size(), partial);
+        kernels::ReproAccumulator total = kernels::reproEmpty();
+        MPI_Reduce(&partial, &total, 1, reproType, reproOp, 0, MPI_COMM_WORLD);
+        double reproTime = MPI_Wtime() - reproStart;
+
+        if (rank == 0) {
+            double reproSum = kernels::reproFinalize(total);
+
+            kernels::ReproAccumulator serial = kernels::reproEmpty();
+            kernels::reproAccumulate(params, fullData.data(), fullData.size(), serial);
+            double serialSum = kernels::reproFinalize(serial);
+            bool matches = withNaN ? std::isnan(reproSum) && std::isnan(serialSum)
+                                   : std::memcmp(&reproSum, &serialSum, sizeof(double)) == 0;
+
+            std::cout << "Array size: " << currSize << fpInputLabel(input)
+                      << ", Plain sum: " << std::hexfloat << plainSum << std::defaultfloat
+                      << " (" << plainTime << " s)"
+                      << ", Reproducible sum: " << std::hexfloat << reproSum << std::defaultfloat
+                      << " (" << reproTime << " s)"
+                      << ", Matches single-process sum: " << (matches ? "yes" : "no") << std::endl;
+        }
+    }
+
+    MPI_Op_free(&reproOp);
+    MPI_Type_free(&reproType);
+}
+
 int main(int argc, char* argv[]) {
     unsigned int seed = 42;
     srand(seed);
@@ -28,6 +286,26 @@ int main(int argc, char* argv[]) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+    if (argc == 3 && std::string(argv[1]) == "--stream") {
+        streamSum(argv[2], rank, size);
+        MPI_Finalize();
+        return 0;
+    }
+    if (argc == 2 && std::string(argv[1]) == "--fp") {
+        compareFloatingSums(rank, size);
+        MPI_Finalize();
+        return 0;
+    }
+
+    // --perf adds per-rank hardware counters and a roofline line to every size.
+    kernels::perf::Machine machine;
+    std::optional<kernels::perf::Counters> counters;
+    if (argc == 2 && std::string(argv[1]) == "--perf") {
+        machine = kernels::perf::measureMachine(MPI_COMM_WORLD);
+        if (rank == 0) kernels::perf::printMachine(std::cout, machine);
+        counters.emplace();
+    }
+
     std::vector<int> testSizes = {10, 1000, 10000000};
 
     for (int currSize : testSizes) {
@@ -41,6 +319,7 @@ int main(int argc, char* argv[]) {
             std::vector<int> full_data(currSize);
             fillRandom(full_data.data(), currSize);
 
+            if (counters) counters->start();
             auto start_time = std::chrono::high_resolution_clock::now();
 
             int offset = 0;
@@ -60,21 +339,29 @@ int main(int argc, char* argv[]) {
             }
 
             auto end_time = std::chrono::high_resolution_clock::now();
+            if (counters) counters->stop();
             std::chrono::duration<double> duration = end_time - start_time;
 
             std::cout << "Array size: " << currSize
                       << ", Total sum: " << sum
                       << ", Time: " << duration.count() << " s." << std::endl;
         } else {
+            if (counters) counters->start();
             MPI_Recv(&localSize, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
             localData = new int[localSize];
             MPI_Recv(localData, localSize, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
             int partial_sum = computeSum(localData, localSize);
             MPI_Send(&partial_sum, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
+            if (counters) counters->stop();
 
             delete[] localData;
         }
+
+        if (counters) {
+            kernels::perf::report(std::cout, "Array size " + std::to_string(currSize), *counters,
+                                  currSize, sizeof(int) * static_cast<double>(currSize), machine, MPI_COMM_WORLD);
+        }
     }
 
     MPI_Finalize();
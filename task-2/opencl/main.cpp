@@ -1,9 +1,16 @@
 #define CL_TARGET_OPENCL_VERSION 300
 #include <CL/cl.h>
+#include "kernels/numa.hpp"
+#include "kernels/reprosum.hpp"
 #include <iostream>
 #include <vector>
 #include <chrono>
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
 
 const char* kernelSource = R"CLC(
 __kernel void reduce_sum(__global const int* input, __global int* partialSums, const int N) {
@@ -32,6 +39,182 @@ __kernel void reduce_sum(__global const int* input, __global int* partialSums, c
 }
 )CLC";
 
+// Double sums for --fp: a plain tree reduction and the binned reproducible
+// sum of kernels/reprosum.hpp. Each work-item folds a contiguous chunk into its
+// own accumulator, work-groups merge them in local memory and the host merges
+// the per-group results; all merges are exact, so the bits do not depend on
+// the work-group size or the number of groups.
+const char* fpKernelSource = R"CLC(
+#define REPRO_FOLDS 3
+#define REPRO_BLOCK 256
+#define REPRO_SCALE 128
+#define MAX_LOCAL 256
+
+__kernel void reduce_sum_double(__global const double* input, __global double* partialSums, const int N) {
+    int gid = get_global_id(0);
+    int groupSize = get_local_size(0);
+    int lid = get_local_id(0);
+    __local double localSums[MAX_LOCAL];
+
+    double sum = 0.0;
+    for (int i = gid; i < N; i += get_global_size(0)) {
+        sum += input[i];
+    }
+    localSums[lid] = sum;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int stride = groupSize / 2; stride > 0; stride /= 2) {
+        if (lid < stride) {
+            localSums[lid] += localSums[lid + stride];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        partialSums[get_group_id(0)] = localSums[0];
+    }
+}
+
+int reproBin(int width, double maxAbs) {
+    if (maxAbs == 0.0) return 0;
+    int exponent;
+    frexp(maxAbs, &exponent);
+    int needed = exponent - width + 1 + 1074;
+    return needed <= 0 ? 0 : (needed + width - 1) / width;
+}
+
+// Folds and boundaries of an accumulator whose top is above maxBin are scaled
+// by 2^-REPRO_SCALE, as in reprosum.hpp.
+int reproScale(int maxBin, int top) {
+    return top > maxBin ? REPRO_SCALE : 0;
+}
+
+double reproBoundary(int width, int bin, int scale) {
+    return ldexp(1.5, bin * width - 1022 - scale);
+}
+
+void reproRaise(int* top, double* fold, int newTop, int maxBin) {
+    if (newTop <= *top) return;
+    int shift = *top < 0 ? REPRO_FOLDS : newTop - *top;
+    int rescale = reproScale(maxBin, newTop) - reproScale(maxBin, *top);
+    for (int k = REPRO_FOLDS - 1; k >= 0; --k) {
+        fold[k] = (k - shift >= 0) ? ldexp(fold[k - shift], -rescale) : 0.0;
+    }
+    *top = newTop;
+}
+
+void reproDeposit(int width, int maxBin, int top, double* fold, double x) {
+    int scale = reproScale(maxBin, top);
+    x = ldexp(x, -scale);
+    for (int k = 0; k < REPRO_FOLDS; ++k) {
+        double m = reproBoundary(width, top - k, scale);
+        double q = (m + x) - m;
+        x -= q;
+        fold[k] += q;
+    }
+}
+
+__kernel void repro_sum(__global const double* input,
+                        __global int* groupTop,
+                        __global double* groupFold,
+                        __global double* groupSpecial,
+                        const int N,
+                        const int chunk,
+                        const int width,
+                        const int maxBin) {
+    int gid = get_global_id(0);
+    int lid = get_local_id(0);
+    int groupSize = get_local_size(0);
+
+    int top = -1;
+    double fold[REPRO_FOLDS] = {0.0, 0.0, 0.0};
+    double special = 0.0;
+
+    int begin = min(gid * chunk, N);
+    int end = min(begin + chunk, N);
+    for (int block = begin; block < end; block += REPRO_BLOCK) {
+        int blockEnd = min(block + REPRO_BLOCK, end);
+
+        // fmax drops NaN, so it is counted separately.
+        double maxAbs = 0.0;
+        int nanCount = 0;
+        for (int i = block; i < blockEnd; ++i) {
+            maxAbs = fmax(maxAbs, fabs(input[i]));
+            nanCount += isnan(input[i]);
+        }
+
+        if (nanCount > 0 || !isfinite(maxAbs)) {
+            for (int i = block; i < blockEnd; ++i) {
+                double x = input[i];
+                if (isfinite(x)) {
+                    reproRaise(&top, fold, reproBin(width, fabs(x)), maxBin);
+                    reproDeposit(width, maxBin, top, fold, x);
+                } else {
+                    special += x;
+                }
+            }
+            continue;
+        }
+
+        reproRaise(&top, fold, reproBin(width, maxAbs), maxBin);
+        int scale = reproScale(maxBin, top);
+        double factor = ldexp(1.0, -scale);
+        double m0 = reproBoundary(width, top, scale);
+        double m1 = reproBoundary(width, top - 1, scale);
+        double m2 = reproBoundary(width, top - 2, scale);
+        for (int i = block; i < blockEnd; ++i) {
+            double x = input[i] * factor;
+            double q0 = (m0 + x) - m0;
+            x -= q0;
+            double q1 = (m1 + x) - m1;
+            x -= q1;
+            double q2 = (m2 + x) - m2;
+            fold[0] += q0;
+            fold[1] += q1;
+            fold[2] += q2;
+        }
+    }
+
+    __local int localTop[MAX_LOCAL];
+    __local double localFold[MAX_LOCAL * REPRO_FOLDS];
+    __local double localSpecial[MAX_LOCAL];
+
+    localTop[lid] = top;
+    for (int k = 0; k < REPRO_FOLDS; ++k) localFold[lid * REPRO_FOLDS + k] = fold[k];
+    localSpecial[lid] = special;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int stride = groupSize / 2; stride > 0; stride /= 2) {
+        if (lid < stride) {
+            int other = lid + stride;
+            localSpecial[lid] += localSpecial[other];
+            int otherTop = localTop[other];
+            if (otherTop >= 0) {
+                int myTop = localTop[lid];
+                double merged[REPRO_FOLDS];
+                for (int k = 0; k < REPRO_FOLDS; ++k) merged[k] = localFold[lid * REPRO_FOLDS + k];
+                reproRaise(&myTop, merged, otherTop, maxBin);
+                int shift = myTop - otherTop;
+                int rescale = reproScale(maxBin, myTop) - reproScale(maxBin, otherTop);
+                for (int k = shift; k < REPRO_FOLDS; ++k) {
+                    merged[k] += ldexp(localFold[other * REPRO_FOLDS + k - shift], -rescale);
+                }
+                localTop[lid] = myTop;
+                for (int k = 0; k < REPRO_FOLDS; ++k) localFold[lid * REPRO_FOLDS + k] = merged[k];
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        int group = get_group_id(0);
+        groupTop[group] = localTop[0];
+        for (int k = 0; k < REPRO_FOLDS; ++k) groupFold[group * REPRO_FOLDS + k] = localFold[k];
+        groupSpecial[group] = localSpecial[0];
+    }
+}
+)CLC";
+
 void check(cl_int err, const char* msg) {
     if (err != CL_SUCCESS) {
         std::cerr << "OpenCL error (" << err << "): " << msg << std::endl;
@@ -39,13 +222,251 @@ void check(cl_int err, const char* msg) {
     }
 }
 
-int main() {
+double reproSumOpenCL(cl_context context, cl_command_queue queue, cl_kernel kernel,
+                      cl_mem inputBuffer, int n, int localSize) {
+    const int chunk = 4 * 256;
+    int items = (n + chunk - 1) / chunk;
+    int numGroups = (items + localSize - 1) / localSize;
+    cl_int err;
+
+    cl_mem topBuffer = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(int) * numGroups, nullptr, &err);
+    check(err, "clCreateBuffer top");
+    cl_mem foldBuffer = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(double) * numGroups * REPRO_FOLDS, nullptr, &err);
+    check(err, "clCreateBuffer fold");
+    cl_mem specialBuffer = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(double) * numGroups, nullptr, &err);
+    check(err, "clCreateBuffer special");
+
+    const kernels::ReproParams params = kernels::reproParams(n);
+    check(clSetKernelArg(kernel, 0, sizeof(cl_mem), &inputBuffer), "set arg 0");
+    check(clSetKernelArg(kernel, 1, sizeof(cl_mem), &topBuffer), "set arg 1");
+    check(clSetKernelArg(kernel, 2, sizeof(cl_mem), &foldBuffer), "set arg 2");
+    check(clSetKernelArg(kernel, 3, sizeof(cl_mem), &specialBuffer), "set arg 3");
+    check(clSetKernelArg(kernel, 4, sizeof(int), &n), "set arg 4");
+    check(clSetKernelArg(kernel, 5, sizeof(int), &chunk), "set arg 5");
+    check(clSetKernelArg(kernel, 6, sizeof(int), &params.width), "set arg 6");
+    check(clSetKernelArg(kernel, 7, sizeof(int), &params.maxBin), "set arg 7");
+
+    size_t globalSize = static_cast<size_t>(localSize) * numGroups;
+    size_t local = localSize;
+    check(clEnqueueNDRangeKernel(queue, kernel, 1, nullptr, &globalSize, &local, 0, nullptr, nullptr), "enqueue repro_sum");
+
+    std::vector<int> tops(numGroups);
+    std::vector<double> folds(numGroups * REPRO_FOLDS), specials(numGroups);
+    check(clEnqueueReadBuffer(queue, topBuffer, CL_TRUE, 0, sizeof(int) * numGroups, tops.data(), 0, nullptr, nullptr), "read top");
+    check(clEnqueueReadBuffer(queue, foldBuffer, CL_TRUE, 0, sizeof(double) * folds.size(), folds.data(), 0, nullptr, nullptr), "read fold");
+    check(clEnqueueReadBuffer(queue, specialBuffer, CL_TRUE, 0, sizeof(double) * numGroups, specials.data(), 0, nullptr, nullptr), "read special");
+
+    kernels::ReproAccumulator total = kernels::reproEmpty();
+    for (int g = 0; g < numGroups; ++g) {
+        kernels::ReproAccumulator group = kernels::reproEmpty();
+        group.top = tops[g];
+        group.scaled = tops[g] > params.maxBin;
+        for (int k = 0; k < REPRO_FOLDS; ++k) group.fold[k] = folds[g * REPRO_FOLDS + k];
+        group.special = specials[g];
+        kernels::reproMerge(total, group);
+    }
+
+    clReleaseMemObject(topBuffer);
+    clReleaseMemObject(foldBuffer);
+    clReleaseMemObject(specialBuffer);
+    return kernels::reproFinalize(total);
+}
+
+double plainSumOpenCL(cl_context context, cl_command_queue queue, cl_kernel kernel,
+                      cl_mem inputBuffer, int n, int localSize) {
+    int numGroups = (n + localSize - 1) / localSize;
+    cl_int err;
+    cl_mem partialBuffer = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(double) * numGroups, nullptr, &err);
+    check(err, "clCreateBuffer partial");
+
+    check(clSetKernelArg(kernel, 0, sizeof(cl_mem), &inputBuffer), "set arg 0");
+    check(clSetKernelArg(kernel, 1, sizeof(cl_mem), &partialBuffer), "set arg 1");
+    check(clSetKernelArg(kernel, 2, sizeof(int), &n), "set arg 2");
+
+    size_t globalSize = static_cast<size_t>(localSize) * numGroups;
+    size_t local = localSize;
+    check(clEnqueueNDRangeKernel(queue, kernel, 1, nullptr, &globalSize, &local, 0, nullptr, nullptr), "enqueue reduce_sum_double");
+
+    std::vector<double> partialSums(numGroups);
+    check(clEnqueueReadBuffer(queue, partialBuffer, CL_TRUE, 0, sizeof(double) * numGroups, partialSums.data(), 0, nullptr, nullptr), "read partial");
+
+    double total = 0.0;
+    for (double p : partialSums) total += p;
+    clReleaseMemObject(partialBuffer);
+    return total;
+}
+
+// Inputs of the --fp checks: values spread over several magnitudes, the same
+// with one NaN in the middle, or with every eighth value near 2^1000, above
+// the highest bin with a finite boundary.
+enum class FpInput { Spread, OneNaN, Huge };
+
+const char* fpInputLabel(FpInput input) {
+    switch (input) {
+        case FpInput::OneNaN: return " (one NaN)";
+        case FpInput::Huge: return " (values near 2^1000)";
+        default: return "";
+    }
+}
+
+// Plain and reproducible double sums for several work-group sizes; the
+// reproducible one must keep its bits and match the host-side sum.
+void compareFloatingSums(cl_context context, cl_device_id device, cl_command_queue queue) {
+    cl_int err;
+    cl_program program = clCreateProgramWithSource(context, 1, &fpKernelSource, nullptr, &err);
+    check(err, "clCreateProgramWithSource fp");
+
+    err = clBuildProgram(program, 1, &device, nullptr, nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        char log[4096];
+        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, sizeof(log), log, nullptr);
+        std::cerr << "Build error:\n" << log << std::endl;
+        std::exit(1);
+    }
+
+    cl_kernel plainKernel = clCreateKernel(program, "reduce_sum_double", &err);
+    check(err, "clCreateKernel reduce_sum_double");
+    cl_kernel reproKernel = clCreateKernel(program, "repro_sum", &err);
+    check(err, "clCreateKernel repro_sum");
+
+    // With a NaN the sums must be NaN.
+    std::vector<std::pair<int, FpInput>> testCases = {
+        {10, FpInput::Spread}, {1000, FpInput::Spread}, {10000000, FpInput::Spread},
+        {1000, FpInput::OneNaN}, {100000, FpInput::Huge}};
+    std::vector<int> localSizes = {64, 128, 256};
+
+    for (auto [n, kind] : testCases) {
+        bool withNaN = kind == FpInput::OneNaN;
+        std::vector<double> input(n);
+        for (int i = 0; i < n; ++i) {
+            double x = (rand() / static_cast<double>(RAND_MAX) - 0.5) * std::pow(10.0, rand() % 8);
+            input[i] = kind == FpInput::Huge && i % 8 == 0 ? std::ldexp(x, 990) : x;
+        }
+        if (withNaN) input[n / 2] = std::numeric_limits<double>::quiet_NaN();
+
+        kernels::ReproAccumulator host = kernels::reproEmpty();
+        kernels::reproAccumulate(kernels::reproParams(n), input.data(), input.size(), host);
+        double hostSum = kernels::reproFinalize(host);
+
+        cl_mem inputBuffer = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(double) * n, input.data(), &err);
+        check(err, "clCreateBuffer input");
+
+        for (int localSize : localSizes) {
+            auto start = std::chrono::high_resolution_clock::now();
+            double plain = plainSumOpenCL(context, queue, plainKernel, inputBuffer, n, localSize);
+            auto middle = std::chrono::high_resolution_clock::now();
+            double repro = reproSumOpenCL(context, queue, reproKernel, inputBuffer, n, localSize);
+            auto end = std::chrono::high_resolution_clock::now();
+
+            std::chrono::duration<double> plainTime = middle - start;
+            std::chrono::duration<double> reproTime = end - middle;
+            bool matches = withNaN ? std::isnan(repro) && std::isnan(hostSum)
+                                   : std::memcmp(&repro, &hostSum, sizeof(double)) == 0;
+
+            std::cout << "Array size: " << n << fpInputLabel(kind)
+                      << ", Work-group size: " << localSize
+                      << ", Plain sum: " << std::hexfloat << plain << std::defaultfloat
+                      << " (" << plainTime.count() << " s)"
+                      << ", Reproducible sum: " << std::hexfloat << repro << std::defaultfloat
+                      << " (" << reproTime.count() << " s)"
+                      << ", Matches host sum: " << (matches ? "yes" : "no")
+                      << std::endl;
+        }
+
+        clReleaseMemObject(inputBuffer);
+    }
+
+    clReleaseKernel(plainKernel);
+    clReleaseKernel(reproKernel);
+    clReleaseProgram(program);
+}
+
+// --numa: the array is split into one contiguous range per NUMA sub-device of
+// the CPU device, each with its own queue, input and partial-sum buffers.
+void sumNuma(cl_platform_id platform, const std::vector<int>& sizes) {
+    kernels::numa::Devices devices = kernels::numa::create(platform);
+    kernels::numa::printDevices(std::cout, devices);
+
+    cl_int err;
+    cl_program program = kernels::numa::build(devices, kernelSource);
+    cl_kernel kernel = clCreateKernel(program, "reduce_sum", &err);
+    check(err, "clCreateKernel");
+
+    const int localSize = 256;
+    const int parts = devices.count();
+
+    for (int n : sizes) {
+        std::vector<int> input(n);
+        for (int i = 0; i < n; ++i) input[i] = rand() % 10;
+
+        std::vector<kernels::numa::Range> ranges(parts);
+        std::vector<int> numGroups(parts, 0);
+        std::vector<cl_mem> inputBuffers(parts, nullptr), partialBuffers(parts, nullptr);
+        for (int p = 0; p < parts; ++p) {
+            ranges[p] = kernels::numa::range(n, parts, p);
+            if (ranges[p].size() == 0) continue;
+            numGroups[p] = (ranges[p].size() + localSize - 1) / localSize;
+            inputBuffers[p] = kernels::numa::localBuffer(devices, p, CL_MEM_READ_ONLY,
+                                                         sizeof(int) * ranges[p].size(), input.data() + ranges[p].begin);
+            partialBuffers[p] = kernels::numa::localBuffer(devices, p, CL_MEM_WRITE_ONLY, sizeof(int) * numGroups[p]);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int p = 0; p < parts; ++p) {
+            if (ranges[p].size() == 0) continue;
+            int count = ranges[p].size();
+            check(clSetKernelArg(kernel, 0, sizeof(cl_mem), &inputBuffers[p]), "set arg 0");
+            check(clSetKernelArg(kernel, 1, sizeof(cl_mem), &partialBuffers[p]), "set arg 1");
+            check(clSetKernelArg(kernel, 2, sizeof(int), &count), "set arg 2");
+
+            size_t globalSize = static_cast<size_t>(localSize) * numGroups[p];
+            size_t local = localSize;
+            check(clEnqueueNDRangeKernel(devices.queues[p], kernel, 1, nullptr, &globalSize, &local, 0, nullptr, nullptr),
+                  "enqueue kernel");
+            check(clFlush(devices.queues[p]), "clFlush");
+        }
+
+        int finalSum = 0;
+        for (int p = 0; p < parts; ++p) {
+            if (ranges[p].size() == 0) continue;
+            std::vector<int> partialSums(numGroups[p]);
+            check(clEnqueueReadBuffer(devices.queues[p], partialBuffers[p], CL_TRUE, 0, sizeof(int) * numGroups[p],
+                                      partialSums.data(), 0, nullptr, nullptr), "read partial");
+            for (int s : partialSums) finalSum += s;
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> duration = end - start;
+
+        std::cout << "Array size: " << n
+                  << ", Sum: " << finalSum
+                  << ", Time: " << duration.count() << " s" << std::endl;
+
+        for (int p = 0; p < parts; ++p) {
+            if (inputBuffers[p]) clReleaseMemObject(inputBuffers[p]);
+            if (partialBuffers[p]) clReleaseMemObject(partialBuffers[p]);
+        }
+    }
+
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+    kernels::numa::release(devices);
+}
+
+int main(int argc, char* argv[]) {
     std::vector<int> sizes = {10, 1000, 10000000};
     cl_int err;
 
     cl_platform_id platform;
     cl_device_id device;
     check(clGetPlatformIDs(1, &platform, nullptr), "clGetPlatformIDs");
+
+    if (argc == 2 && std::string(argv[1]) == "--numa") {
+        sumNuma(platform, sizes);
+        return 0;
+    }
+
     check(clGetDeviceIDs(platform, CL_DEVICE_TYPE_DEFAULT, 1, &device, nullptr), "clGetDeviceIDs");
 
     cl_context context = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &err);
@@ -68,6 +489,16 @@ int main() {
     cl_kernel kernel = clCreateKernel(program, "reduce_sum", &err);
     check(err, "clCreateKernel");
 
+    if (argc == 2 && std::string(argv[1]) == "--fp") {
+        compareFloatingSums(context, device, queue);
+
+        clReleaseKernel(kernel);
+        clReleaseProgram(program);
+        clReleaseCommandQueue(queue);
+        clReleaseContext(context);
+        return 0;
+    }
+
     for (int n : sizes) {
         std::vector<int> input(n);
         for (int i = 0; i < n; ++i) input[i] = rand() % 10;
@@ -1,7 +1,28 @@
+#include "kernels/perf.hpp"
+#include "kernels/reprosum.hpp"
+
 #include <omp.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
-#include <cstdlib>
+
+// Window of the mapped file a thread sums before releasing it. Each thread
+// keeps at most the current and the prefetched window resident.
+constexpr size_t streamWindowBytes = 8 << 20;
 
 std::vector<int> createRandomVector(int length) {
     std::vector<int> data(length);
@@ -11,15 +32,284 @@ std::vector<int> createRandomVector(int length) {
     return data;
 }
 
-int main() {
+void generateFile(const char* path, long long count) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror(path);
+        std::exit(1);
+    }
+
+    std::vector<int> block(1 << 20);
+    for (long long written = 0; written < count; written += block.size()) {
+        size_t chunk = std::min<long long>(block.size(), count - written);
+        for (size_t i = 0; i < chunk; ++i) block[i] = rand() % 10;
+        if (fwrite(block.data(), sizeof(int), chunk, file) != chunk) {
+            perror(path);
+            std::exit(1);
+        }
+    }
+    fclose(file);
+
+    std::cout << "Generated " << count << " ints in " << path << std::endl;
+}
+
+int openInput(const char* path, size_t& bytes) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        perror(path);
+        std::exit(1);
+    }
+    bytes = info.st_size;
+    return fd;
+}
+
+// Plain single-threaded read() of the whole file after evicting it from the
+// page cache: the disk's sequential bandwidth the stream is compared to.
+double measureSequentialRead(const char* path) {
+    size_t bytes;
+    int fd = openInput(path, bytes);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<char> buffer(streamWindowBytes);
+    double timeStart = omp_get_wtime();
+    while (read(fd, buffer.data(), buffer.size()) > 0) {
+    }
+    double timeEnd = omp_get_wtime();
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    return bytes / (timeEnd - timeStart) / 1e9;
+}
+
+void streamSum(const char* path) {
+    double rawBandwidth = measureSequentialRead(path);
+
+    size_t bytes;
+    int fd = openInput(path, bytes);
+    size_t count = bytes / sizeof(int);
+    if (count == 0) {
+        std::cerr << path << " holds no ints" << std::endl;
+        std::exit(1);
+    }
+
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        perror("mmap");
+        std::exit(1);
+    }
+    madvise(mapping, bytes, MADV_SEQUENTIAL);
+
+    const int* data = static_cast<const int*>(mapping);
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    const size_t windowElems = streamWindowBytes / sizeof(int);
+
+    double timeStart = omp_get_wtime();
+
+    long long totalSum = 0;
+#pragma omp parallel reduction(+ : totalSum)
+    {
+        int thread = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        size_t begin = count * thread / threads;
+        size_t end = count * (thread + 1) / threads;
+
+        // Page-aligned [first, last) byte range of elements [from, to).
+        auto pages = [&](size_t from, size_t to, char*& first, size_t& length) {
+            uintptr_t lo = reinterpret_cast<uintptr_t>(data + from) & ~(pageSize - 1);
+            uintptr_t hi = reinterpret_cast<uintptr_t>(data + to);
+            first = reinterpret_cast<char*>(lo);
+            length = hi - lo;
+        };
+
+        for (size_t window = begin; window < end; window += windowElems) {
+            size_t windowEnd = std::min(window + windowElems, end);
+
+            // Kernel read-ahead of the next window overlaps with summing this one.
+            if (windowEnd < end) {
+                char* first;
+                size_t length;
+                pages(windowEnd, std::min(windowEnd + windowElems, end), first, length);
+                madvise(first, length, MADV_WILLNEED);
+            }
+
+            long long partial = 0;
+#pragma omp simd reduction(+ : partial)
+            for (size_t i = window; i < windowEnd; ++i) {
+                partial += data[i];
+            }
+            totalSum += partial;
+
+            // Release the consumed window so the resident set stays bounded.
+            char* first;
+            size_t length;
+            pages(window, windowEnd, first, length);
+            madvise(first, length, MADV_DONTNEED);
+        }
+    }
+
+    double timeEnd = omp_get_wtime();
+
+    munmap(mapping, bytes);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double elapsed = timeEnd - timeStart;
+    double bandwidth = bytes / elapsed / 1e9;
+    std::cout << "Stream file: " << path
+              << ", Elements: " << count
+              << ", Computed sum: " << totalSum
+              << ", Execution time: " << elapsed << " s"
+              << ", Throughput: " << bandwidth << " GB/s"
+              << ", Raw sequential read: " << rawBandwidth << " GB/s"
+              << " (" << 100.0 * bandwidth / rawBandwidth << "%)"
+              << ", Peak RSS: " << usage.ru_maxrss / 1024 << " MiB" << std::endl;
+}
+
+template <typename T>
+T plainSum(const std::vector<T>& data) {
+    T total = 0;
+#pragma omp parallel for simd reduction(+ : total)
+    for (size_t i = 0; i < data.size(); ++i) {
+        total += data[i];
+    }
+    return total;
+}
+
+// Per-thread binned accumulators merged exactly, so the bits do not depend
+// on the number of threads or on the order of the merges.
+template <typename T>
+T reproducibleSum(const std::vector<T>& data) {
+    const size_t n = data.size();
+    const kernels::ReproParams params = kernels::reproParams(n);
+    kernels::ReproAccumulator total = kernels::reproEmpty();
+
+#pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        size_t begin = n * thread / threads;
+        size_t end = n * (thread + 1) / threads;
+
+        kernels::ReproAccumulator acc = kernels::reproEmpty();
+        kernels::reproAccumulate(params, data.data() + begin, end - begin, acc);
+
+#pragma omp critical
+        kernels::reproMerge(total, acc);
+    }
+    return static_cast<T>(kernels::reproFinalize(total));
+}
+
+// Identical bits, or both NaN (whose payload bits are not specified).
+template <typename T>
+bool sameBits(T a, T b) {
+    return std::memcmp(&a, &b, sizeof(T)) == 0 || (std::isnan(a) && std::isnan(b));
+}
+
+// Inputs of the --fp checks: values spread over several magnitudes, the same
+// with one NaN in the middle, or with every eighth value near 2^1000, above
+// the highest bin with a finite boundary.
+enum class FpInput { Spread, OneNaN, Huge };
+
+const char* fpInputLabel(FpInput input) {
+    switch (input) {
+        case FpInput::OneNaN: return " (one NaN)";
+        case FpInput::Huge: return " (values near 2^1000)";
+        default: return "";
+    }
+}
+
+// Sums values spread over several magnitudes with every thread count and
+// checks which results keep their bits. Sums with a NaN must be NaN; values
+// near 2^1000 only fit in double.
+template <typename T>
+void compareFloatingSums(const char* typeName) {
+    const std::vector<int> threadCounts = {1, 2, 3, 4, 8};
+    std::vector<std::pair<int, FpInput>> testCases = {
+        {10, FpInput::Spread}, {1000, FpInput::Spread}, {10000000, FpInput::Spread}, {1000, FpInput::OneNaN}};
+    if (std::numeric_limits<T>::max_exponent > 1000) testCases.push_back({100000, FpInput::Huge});
+
+    for (auto [currentSize, input] : testCases) {
+        std::vector<T> inputData(currentSize);
+        for (int i = 0; i < currentSize; ++i) {
+            double x = (rand() / static_cast<double>(RAND_MAX) - 0.5) * std::pow(10.0, rand() % 8);
+            inputData[i] = static_cast<T>(input == FpInput::Huge && i % 8 == 0 ? std::ldexp(x, 990) : x);
+        }
+        if (input == FpInput::OneNaN) inputData[currentSize / 2] = std::numeric_limits<T>::quiet_NaN();
+
+        T firstPlain = 0, firstRepro = 0;
+        bool plainStable = true, reproStable = true;
+
+        for (size_t t = 0; t < threadCounts.size(); ++t) {
+            omp_set_num_threads(threadCounts[t]);
+
+            double timeStart = omp_get_wtime();
+            T plain = plainSum(inputData);
+            double plainTime = omp_get_wtime() - timeStart;
+
+            timeStart = omp_get_wtime();
+            T repro = reproducibleSum(inputData);
+            double reproTime = omp_get_wtime() - timeStart;
+
+            if (t == 0) {
+                firstPlain = plain;
+                firstRepro = repro;
+            }
+            plainStable = plainStable && sameBits(plain, firstPlain);
+            reproStable = reproStable && sameBits(repro, firstRepro) && std::isnan(repro) == (input == FpInput::OneNaN);
+
+            std::cout << "Type: " << typeName
+                      << ", Array size: " << currentSize << fpInputLabel(input)
+                      << ", Threads: " << threadCounts[t]
+                      << ", Plain sum: " << std::hexfloat << plain << std::defaultfloat
+                      << " (" << plainTime << " s)"
+                      << ", Reproducible sum: " << std::hexfloat << repro << std::defaultfloat
+                      << " (" << reproTime << " s, x" << reproTime / plainTime << ")" << std::endl;
+        }
+
+        std::cout << "Type: " << typeName << ", Array size: " << currentSize << fpInputLabel(input)
+                  << ", Bit-identical across thread counts: plain " << (plainStable ? "yes" : "no")
+                  << ", reproducible " << (reproStable ? "yes" : "no") << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
     const unsigned int randomSeed = 42;
     srand(randomSeed);
 
+    if (argc == 4 && std::string(argv[1]) == "--generate") {
+        generateFile(argv[2], std::atoll(argv[3]));
+        return 0;
+    }
+    if (argc == 3 && std::string(argv[1]) == "--stream") {
+        streamSum(argv[2]);
+        return 0;
+    }
+    if (argc == 2 && std::string(argv[1]) == "--fp") {
+        compareFloatingSums<double>("double");
+        compareFloatingSums<float>("float");
+        return 0;
+    }
+
+    // --perf adds hardware counters and a roofline line to every size.
+    kernels::perf::Machine machine;
+    std::optional<kernels::perf::Counters> counters;
+    if (argc == 2 && std::string(argv[1]) == "--perf") {
+        machine = kernels::perf::measureMachine();
+        kernels::perf::printMachine(std::cout, machine);
+        counters.emplace();
+    }
+
     std::vector<int> arraySizes = {10, 1000, 10000000};
 
     for (int currentSize : arraySizes) {
         std::vector<int> inputData = createRandomVector(currentSize);
 
+        if (counters) counters->start();
         double timeStart = omp_get_wtime();
 
         int totalSum = 0;
@@ -29,11 +319,17 @@ int main() {
         }
 
         double timeEnd = omp_get_wtime();
+        if (counters) counters->stop();
 
         std::cout << "Array size: " << currentSize
                   << ", Computed sum: " << totalSum
                   << ", Execution time: " << (timeEnd - timeStart)
                   << " s" << std::endl;
+
+        if (counters) {
+            kernels::perf::report(std::cout, "Array size " + std::to_string(currentSize), *counters,
+                                  currentSize, sizeof(int) * static_cast<double>(currentSize), machine);
+        }
     }
 
     return 0;
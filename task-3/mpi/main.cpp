@@ -1,5 +1,14 @@
 #include <mpi.h>
+
+#include "kernels/perf.hpp"
+#include "kernels/schedule.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <vector>
 #include <chrono>
 #include <cmath>
@@ -35,6 +44,234 @@ void computeDerivativeX(int startRow, int numRows, int cols) {
     }
 }
 
+// ====Dynamic scheduling====
+
+void computeDerivativeRows(const double* input, double* output, int numRows, int cols) {
+    for (int i = 0; i < numRows; ++i) {
+        const double* in = input + static_cast<size_t>(i) * cols;
+        double* out = output + static_cast<size_t>(i) * cols;
+        out[0] = (in[1] - in[0]) / dx;
+        for (int j = 1; j < cols - 1; ++j) {
+            out[j] = (in[j + 1] - in[j - 1]) / (2 * dx);
+        }
+        out[cols - 1] = (in[cols - 1] - in[cols - 2]) / dx;
+    }
+}
+
+// Rank 0 hands out row tiles of matrixA with kernels::schedule and receives
+// the derivative rows straight into matrixB.
+void runDynamic(int rank, int numProcesses, int rows, int cols) {
+    // One row of the static matrices: cols doubles with a stride of maxSize.
+    MPI_Datatype rowContiguous, rowType;
+    MPI_Type_contiguous(cols, MPI_DOUBLE, &rowContiguous);
+    MPI_Type_create_resized(rowContiguous, 0, sizeof(double) * maxSize, &rowType);
+    MPI_Type_commit(&rowType);
+    MPI_Type_free(&rowContiguous);
+
+    const int numWorkers = numProcesses - 1;
+
+    if (rank == 0) {
+        generateMatrix(rows, cols);
+        MPI_Barrier(MPI_COMM_WORLD);
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        kernels::schedule::Stats stats{1, rows};
+        if (numWorkers == 0) {
+            computeDerivativeX(0, rows, cols);
+        } else {
+            stats = kernels::schedule::distributeTiles(MPI_COMM_WORLD, rowType, &matrixA[0][0], &matrixB[0][0], rows);
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = endTime - startTime;
+
+        // Time each worker finished its last tile, to show how evenly the work ended.
+        double masterFinish = 0.0;
+        std::vector<double> finish(numProcesses);
+        MPI_Gather(&masterFinish, 1, MPI_DOUBLE, finish.data(), 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        double firstFinish = 0.0, lastFinish = 0.0;
+        if (numWorkers > 0) {
+            firstFinish = *std::min_element(finish.begin() + 1, finish.end());
+            lastFinish = *std::max_element(finish.begin() + 1, finish.end());
+        }
+
+        std::cout << "Grid size: " << rows << "x" << cols
+                  << ", Execution time: " << elapsed.count() << " seconds"
+                  << ", Tiles: " << stats.tiles
+                  << ", Last tile rows: " << stats.lastTileRows
+                  << ", Worker finish spread: " << lastFinish - firstFinish << " seconds" << std::endl;
+    } else {
+        MPI_Barrier(MPI_COMM_WORLD);
+        double startTime = MPI_Wtime();
+
+        kernels::schedule::workTiles(MPI_COMM_WORLD, rows, cols, [&](const double* input, double* output, int numRows) {
+            computeDerivativeRows(input, output, numRows, cols);
+        });
+
+        double finish = MPI_Wtime() - startTime;
+        MPI_Gather(&finish, 1, MPI_DOUBLE, nullptr, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    }
+
+    MPI_Type_free(&rowType);
+}
+
+// ====Time stepping====
+
+// Explicit advection-diffusion u_t + a u_x = nu (u_xx + u_yy): forward Euler
+// with the central x-derivative of computeDerivativeX and the 5-point
+// Laplacian. The grid frame keeps its initial values. The diffusion number
+// nu dt / dx^2 is 0.2 and the cell Peclet number a dx / nu is 1, both stable.
+constexpr double advection = 1.0;
+constexpr double diffusion = 0.01;
+constexpr double dt = 0.2 * dx * dx / diffusion;
+
+// dt, dx and the coefficients folded, so a point costs no division.
+constexpr double diffusionNumber = diffusion * dt / (dx * dx);
+constexpr double halfCourant = advection * dt / (2 * dx);
+
+constexpr int tagHalo = 4;
+
+inline double advancePoint(double center, double up, double down, double left, double right) {
+    return center + diffusionNumber * (up + down + left + right - 4 * center) - halfCourant * (right - left);
+}
+
+// One step of global rows [rowBegin, rowEnd); in and out hold global row
+// firstRow at index 0. The first and last row and column are fixed.
+void advanceRows(const double* in, double* out, int firstRow, int rowBegin, int rowEnd, int rows, int cols) {
+    for (int i = rowBegin; i < rowEnd; ++i) {
+        const double* row = in + static_cast<size_t>(i - firstRow) * cols;
+        double* target = out + static_cast<size_t>(i - firstRow) * cols;
+        if (i == 0 || i == rows - 1) {
+            std::copy(row, row + cols, target);
+            continue;
+        }
+        const double* up = row - cols;
+        const double* down = row + cols;
+        target[0] = row[0];
+        for (int j = 1; j < cols - 1; ++j) {
+            target[j] = advancePoint(row[j], up[j], down[j], row[j - 1], row[j + 1]);
+        }
+        target[cols - 1] = row[cols - 1];
+    }
+}
+
+// Every rank owns a block of rows plus `depth` ghost rows on each side and
+// exchanges the ghost rows with its neighbours only every `depth` steps. In
+// between, step s of a block also advances the depth - 1 - s ghost rows next
+// to the owned ones, so the ghost zone shrinks by a row per step and the owned
+// rows stay exact: one message per neighbour per `depth` steps, paid for with
+// redundant updates of the ghost rows. Returns the slowest rank's time; the
+// result ends up in matrixB on rank 0.
+double solveDeepHalo(int rank, int numProcesses, int rows, int cols, int steps, int depth) {
+    int rowsPerProcess = rows / numProcesses;
+    int remainingRows = rows % numProcesses;
+    int begin = rank * rowsPerProcess;
+    int end = begin + rowsPerProcess + (rank == numProcesses - 1 ? remainingRows : 0);
+    int firstRow = begin - depth;
+    int localRows = end - begin + 2 * depth;
+
+    std::vector<double> u(static_cast<size_t>(localRows) * cols), next(u.size());
+    auto local = [&](std::vector<double>& field, int row) { return &field[static_cast<size_t>(row - firstRow) * cols]; };
+    for (int i = begin; i < end; ++i)
+        for (int j = 0; j < cols; ++j)
+            local(u, i)[j] = computeFunction(i * dx, j * dx);
+
+    int up = rank > 0 ? rank - 1 : MPI_PROC_NULL;
+    int down = rank < numProcesses - 1 ? rank + 1 : MPI_PROC_NULL;
+    int haloCount = depth * cols;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double startTime = MPI_Wtime();
+
+    for (int step = 0; step < steps; step += depth) {
+        MPI_Sendrecv(local(u, begin), haloCount, MPI_DOUBLE, up, tagHalo,
+                     local(u, end), haloCount, MPI_DOUBLE, down, tagHalo, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Sendrecv(local(u, end - depth), haloCount, MPI_DOUBLE, down, tagHalo,
+                     local(u, begin - depth), haloCount, MPI_DOUBLE, up, tagHalo, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        int blockSteps = std::min(depth, steps - step);
+        for (int s = 0; s < blockSteps; ++s) {
+            int extra = blockSteps - 1 - s;
+            int rowBegin = std::max(begin - extra, 0);
+            int rowEnd = std::min(end + extra, rows);
+            advanceRows(u.data(), next.data(), firstRow, rowBegin, rowEnd, rows, cols);
+            std::swap(u, next);
+        }
+    }
+
+    double elapsed = MPI_Wtime() - startTime;
+    double slowest;
+    MPI_Reduce(&elapsed, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    std::vector<int> counts(numProcesses), displs(numProcesses);
+    for (int proc = 0; proc < numProcesses; ++proc) {
+        counts[proc] = (rowsPerProcess + (proc == numProcesses - 1 ? remainingRows : 0)) * cols;
+        displs[proc] = proc * rowsPerProcess * cols;
+    }
+    std::vector<double> result(rank == 0 ? static_cast<size_t>(rows) * cols : 0);
+    MPI_Gatherv(local(u, begin), (end - begin) * cols, MPI_DOUBLE,
+                result.data(), counts.data(), displs.data(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        for (int i = 0; i < rows; ++i)
+            std::copy(&result[static_cast<size_t>(i) * cols], &result[static_cast<size_t>(i + 1) * cols], &matrixB[i][0]);
+    }
+    return slowest;
+}
+
+// --solve [steps] [depth]: time stepping with ghost zones one row deep
+// (an exchange every step) and `depth` rows deep, checked against a serial
+// run on rank 0.
+void runSolver(int rank, int numProcesses, int steps, int depth) {
+    std::vector<int> solverSizes = {100, 1000, 4000};
+
+    for (int size : solverSizes) {
+        int rows = size;
+        int cols = size;
+        // Ghost rows come from the direct neighbours only.
+        int maxDepth = std::max(rows / numProcesses, 1);
+
+        std::vector<double> reference;
+        if (rank == 0) {
+            std::vector<double> next(static_cast<size_t>(rows) * cols);
+            reference.resize(next.size());
+            for (int i = 0; i < rows; ++i)
+                for (int j = 0; j < cols; ++j)
+                    reference[static_cast<size_t>(i) * cols + j] = computeFunction(i * dx, j * dx);
+            for (int step = 0; step < steps; ++step) {
+                advanceRows(reference.data(), next.data(), 0, 0, rows, rows, cols);
+                std::swap(reference, next);
+            }
+        }
+
+        for (int haloDepth : {1, std::min(depth, maxDepth)}) {
+            double elapsed = solveDeepHalo(rank, numProcesses, rows, cols, steps, haloDepth);
+
+            if (rank == 0) {
+                double maxDifference = 0.0;
+                for (int i = 0; i < rows; ++i)
+                    for (int j = 0; j < cols; ++j)
+                        maxDifference = std::max(maxDifference, std::abs(matrixB[i][j] - reference[static_cast<size_t>(i) * cols + j]));
+
+                std::cout << "Grid size: " << rows << "x" << cols
+                          << ", Steps: " << steps
+                          << ", Halo depth: " << haloDepth
+                          << ", Exchanges: " << (steps + haloDepth - 1) / haloDepth
+                          << ", Execution time: " << elapsed << " seconds"
+                          << ", Max difference: " << maxDifference << std::endl;
+            }
+        }
+    }
+}
+
+// Optional positive integer argument argv[index]: fallback when absent, 0
+// when it is not a whole number >= 1.
+int positiveArgument(int argc, char* argv[], int index, int fallback) {
+    if (argc <= index) return fallback;
+    char* end;
+    long value = std::strtol(argv[index], &end, 10);
+    return (*end == '\0' && value >= 1 && value <= INT_MAX) ? static_cast<int>(value) : 0;
+}
+
 int main(int argc, char* argv[]) {
     int rank, numProcesses;
     MPI_Status status;
@@ -45,6 +282,36 @@ int main(int argc, char* argv[]) {
 
     std::vector<int> gridSizes = {10, 100, 1000, 10000};
 
+    if (argc > 1 && std::string(argv[1]) == "--solve") {
+        int steps = positiveArgument(argc, argv, 2, 100);
+        int depth = positiveArgument(argc, argv, 3, 8);
+        if (steps == 0 || depth == 0) {
+            if (rank == 0) std::cerr << "Usage: " << argv[0] << " --solve [steps >= 1] [depth >= 1]" << std::endl;
+            MPI_Finalize();
+            return 1;
+        }
+        runSolver(rank, numProcesses, steps, depth);
+        MPI_Finalize();
+        return 0;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--dynamic") {
+        for (auto size : gridSizes) {
+            runDynamic(rank, numProcesses, size, size);
+        }
+        MPI_Finalize();
+        return 0;
+    }
+
+    // --perf adds per-rank hardware counters and a roofline line to every size.
+    kernels::perf::Machine machine;
+    std::optional<kernels::perf::Counters> counters;
+    if (argc == 2 && std::string(argv[1]) == "--perf") {
+        machine = kernels::perf::measureMachine(MPI_COMM_WORLD);
+        if (rank == 0) kernels::perf::printMachine(std::cout, machine);
+        counters.emplace();
+    }
+
     for (auto size : gridSizes) {
         int rows = size;
         int cols = size;
@@ -55,6 +322,7 @@ int main(int argc, char* argv[]) {
         if (rank == 0) {
             generateMatrix(rows, cols);
 
+            if (counters) counters->start();
             auto startTime = std::chrono::high_resolution_clock::now();
 
             for (int proc = 1; proc < numProcesses; ++proc) {
@@ -76,11 +344,13 @@ int main(int argc, char* argv[]) {
             }
 
             auto endTime = std::chrono::high_resolution_clock::now();
+            if (counters) counters->stop();
             std::chrono::duration<double> elapsed = endTime - startTime;
 
             std::cout << "Grid size: " << rows << "x" << cols
                       << ", Execution time: " << elapsed.count() << " seconds" << std::endl;
         } else {
+            if (counters) counters->start();
             int numRowsToProcess, startRow;
             MPI_Recv(&numRowsToProcess, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
             MPI_Recv(&startRow, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
@@ -92,6 +362,13 @@ int main(int argc, char* argv[]) {
             MPI_Send(&numRowsToProcess, 1, MPI_INT, 0, 1, MPI_COMM_WORLD);
             MPI_Send(&startRow, 1, MPI_INT, 0, 1, MPI_COMM_WORLD);
             MPI_Send(&matrixB[startRow][0], numRowsToProcess * cols, MPI_DOUBLE, 0, 1, MPI_COMM_WORLD);
+            if (counters) counters->stop();
+        }
+
+        if (counters) {
+            double points = static_cast<double>(rows) * cols;
+            kernels::perf::report(std::cout, "Grid size " + std::to_string(size), *counters,
+                                  2 * points, 2 * sizeof(double) * points, machine, MPI_COMM_WORLD);
         }
     }
 
@@ -1,5 +1,6 @@
 #define CL_TARGET_OPENCL_VERSION 300
 #include <CL/cl.h>
+#include "kernels/numa.hpp"
 
 #include <iostream>
 #include <vector>
@@ -7,6 +8,7 @@
 #include <chrono>
 #include <fstream>
 #include <sstream>
+#include <string>
 
 const char* kernelSource = R"CLC(
 __kernel void computeDerivativeX(__global const double* input,
@@ -39,7 +41,86 @@ double func(double x, double y) {
     return x * (sin(x) + cos(y));
 }
 
-int main() {
+// --numa: the grid rows are split into one contiguous block per NUMA
+// sub-device of the CPU device. The derivative runs along the rows, so the
+// blocks need no halo; each has its own queue and buffers.
+void derivativeNuma(cl_platform_id platform, const std::vector<int>& sizes) {
+    kernels::numa::Devices devices = kernels::numa::create(platform);
+    kernels::numa::printDevices(std::cout, devices);
+
+    cl_int err;
+    cl_program program = kernels::numa::build(devices, kernelSource);
+    cl_kernel kernel = clCreateKernel(program, "computeDerivativeX", &err);
+    kernels::numa::check(err, "clCreateKernel");
+
+    const int parts = devices.count();
+
+    for (int size : sizes) {
+        int rows = size;
+        int cols = size;
+        size_t totalSize = rows * cols;
+
+        std::vector<double> inputData(totalSize);
+        std::vector<double> outputData(totalSize, 0);
+
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                inputData[i * cols + j] = func(i * dx, j * dx);
+
+        std::vector<kernels::numa::Range> ranges(parts);
+        std::vector<cl_mem> inputBuffers(parts, nullptr), outputBuffers(parts, nullptr);
+        for (int p = 0; p < parts; p++) {
+            ranges[p] = kernels::numa::range(rows, parts, p);
+            if (ranges[p].size() == 0) continue;
+            size_t bytes = sizeof(double) * ranges[p].size() * cols;
+            inputBuffers[p] = kernels::numa::localBuffer(devices, p, CL_MEM_READ_ONLY, bytes,
+                                                         inputData.data() + ranges[p].begin * cols);
+            outputBuffers[p] = kernels::numa::localBuffer(devices, p, CL_MEM_WRITE_ONLY, bytes);
+        }
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        for (int p = 0; p < parts; p++) {
+            if (ranges[p].size() == 0) continue;
+            int partRows = ranges[p].size();
+            clSetKernelArg(kernel, 0, sizeof(cl_mem), &inputBuffers[p]);
+            clSetKernelArg(kernel, 1, sizeof(cl_mem), &outputBuffers[p]);
+            clSetKernelArg(kernel, 2, sizeof(int), &partRows);
+            clSetKernelArg(kernel, 3, sizeof(int), &cols);
+            clSetKernelArg(kernel, 4, sizeof(double), &dx);
+
+            size_t globalWorkSize = partRows;
+            err = clEnqueueNDRangeKernel(devices.queues[p], kernel, 1, nullptr, &globalWorkSize, nullptr, 0, nullptr, nullptr);
+            kernels::numa::check(err, "enqueue kernel");
+            clFlush(devices.queues[p]);
+        }
+
+        for (int p = 0; p < parts; p++) {
+            if (ranges[p].size() == 0) continue;
+            clEnqueueReadBuffer(devices.queues[p], outputBuffers[p], CL_TRUE, 0,
+                                sizeof(double) * ranges[p].size() * cols,
+                                outputData.data() + ranges[p].begin * cols, 0, nullptr, nullptr);
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+
+        std::chrono::duration<double> elapsed = endTime - startTime;
+
+        std::cout << "Grid size: " << rows << "x" << cols
+                  << ", Execution time: " << elapsed.count() << " seconds" << std::endl;
+
+        for (int p = 0; p < parts; p++) {
+            if (inputBuffers[p]) clReleaseMemObject(inputBuffers[p]);
+            if (outputBuffers[p]) clReleaseMemObject(outputBuffers[p]);
+        }
+    }
+
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+    kernels::numa::release(devices);
+}
+
+int main(int argc, char* argv[]) {
     std::vector<int> sizes = {10, 100, 1000, 10000};
 
     cl_int err;
@@ -54,6 +135,11 @@ int main() {
         return 1;
     }
 
+    if (argc == 2 && std::string(argv[1]) == "--numa") {
+        derivativeNuma(platform, sizes);
+        return 0;
+    }
+
     err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_DEFAULT, 1, &device, nullptr);
     if (err != CL_SUCCESS) {
         std::cerr << "Failed to get device." << std::endl;
@@ -1,6 +1,13 @@
+#include "kernels/perf.hpp"
+
 #include <omp.h>
+#include <algorithm>
+#include <climits>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <vector>
 
 double computeFunction(double x, double y) {
@@ -27,9 +34,183 @@ void computePartialDerivativeX(const std::vector<std::vector<double>>& input,
     }
 }
 
-int main() {
+// ====Time stepping====
+
+constexpr double dx = 0.01;
+
+// Explicit advection-diffusion u_t + a u_x = nu (u_xx + u_yy): forward Euler
+// with the central x-derivative of computePartialDerivativeX and the 5-point
+// Laplacian. The grid frame keeps its initial values. The diffusion number
+// nu dt / dx^2 is 0.2 and the cell Peclet number a dx / nu is 1, both stable.
+constexpr double advection = 1.0;
+constexpr double diffusion = 0.01;
+constexpr double dt = 0.2 * dx * dx / diffusion;
+
+// Temporal blocking: steps advanced per pass over the grid, and the widest
+// column tile that a thread advances through all of those steps (its rings
+// of rows stay in cache).
+constexpr int blockSteps = 8;
+constexpr int tileCols = 512;
+
+// dt, dx and the coefficients folded, so a point costs no division.
+constexpr double diffusionNumber = diffusion * dt / (dx * dx);
+constexpr double halfCourant = advection * dt / (2 * dx);
+
+inline double advancePoint(double center, double up, double down, double left, double right) {
+    return center + diffusionNumber * (up + down + left + right - 4 * center) - halfCourant * (right - left);
+}
+
+// Advances columns [begin, end) of an interior row from rows up, row, down of
+// the previous step; the first and last column are fixed.
+void advanceRow(const double* up, const double* row, const double* down, double* out,
+                int begin, int end, int cols) {
+    if (begin == 0) out[0] = row[0];
+    if (end == cols) out[cols - 1] = row[cols - 1];
+    int first = std::max(begin, 1);
+    int last = std::min(end, cols - 1);
+#pragma omp simd
+    for (int j = first; j < last; ++j) {
+        out[j] = advancePoint(row[j], up[j], down[j], row[j - 1], row[j + 1]);
+    }
+}
+
+// One step over the whole grid.
+void stepNaive(const std::vector<double>& u, std::vector<double>& next, int rows, int cols) {
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < rows; ++i) {
+        const double* row = &u[static_cast<size_t>(i) * cols];
+        double* out = &next[static_cast<size_t>(i) * cols];
+        if (i == 0 || i == rows - 1) {
+            std::copy(row, row + cols, out);
+        } else {
+            advanceRow(row - cols, row, row + cols, out, 0, cols, cols);
+        }
+    }
+}
+
+// `levels` steps in one pass: every thread takes column tiles and sweeps a
+// wavefront down the rows, advancing row i to step 1, row i - 1 to step 2, ...,
+// row i - levels + 1 to step `levels` before moving on, so each row of the
+// tile is reused from cache for all steps. Intermediate steps live in rings of
+// three rows per step. Step t of a tile is computed levels - t columns beyond
+// the tile on both sides (redundantly with the neighbour tiles), which keeps
+// the tiles independent. Tiles are narrowed below tileCols until every thread
+// gets one, but not below the `levels` columns of halo they recompute.
+void stepBlocked(const std::vector<double>& u, std::vector<double>& next, int rows, int cols, int levels) {
+    int threads = omp_get_max_threads();
+    int width = std::max(std::min(tileCols, (cols + threads - 1) / threads), levels);
+    int numTiles = (cols + width - 1) / width;
+
+#pragma omp parallel
+    {
+        std::vector<double> ring(static_cast<size_t>(levels - 1) * 3 * cols);
+        auto source = [&](int level, int i) -> const double* {
+            if (level == 0) return &u[static_cast<size_t>(i) * cols];
+            return &ring[(static_cast<size_t>(level - 1) * 3 + i % 3) * cols];
+        };
+        auto target = [&](int level, int i) -> double* {
+            if (level == levels) return &next[static_cast<size_t>(i) * cols];
+            return &ring[(static_cast<size_t>(level - 1) * 3 + i % 3) * cols];
+        };
+
+#pragma omp for schedule(dynamic)
+        for (int tile = 0; tile < numTiles; ++tile) {
+            int tileBegin = tile * width;
+            int tileEnd = std::min(tileBegin + width, cols);
+
+            for (int front = 0; front < rows + levels - 1; ++front) {
+                for (int level = 1; level <= levels; ++level) {
+                    int i = front - (level - 1);
+                    if (i < 0 || i >= rows) continue;
+
+                    int begin = std::max(tileBegin - (levels - level), 0);
+                    int end = std::min(tileEnd + (levels - level), cols);
+                    double* out = target(level, i);
+                    if (i == 0 || i == rows - 1) {
+                        std::copy(source(0, i) + begin, source(0, i) + end, out + begin);
+                    } else {
+                        advanceRow(source(level - 1, i - 1), source(level - 1, i), source(level - 1, i + 1),
+                                   out, begin, end, cols);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// --solve [steps]: runs the time stepping step by step and with temporal
+// blocking; both must produce the same bits.
+void solve(int steps) {
+    std::vector<int> solverSizes = {100, 1000, 4000};
+
+    for (int size : solverSizes) {
+        int rows = size;
+        int cols = size;
+        size_t points = static_cast<size_t>(rows) * cols;
+
+        std::vector<double> u(points), next(points);
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < cols; ++j)
+                u[static_cast<size_t>(i) * cols + j] = computeFunction(i * dx, j * dx);
+        std::vector<double> reference = u, referenceNext(points);
+
+        double startTime = omp_get_wtime();
+        for (int step = 0; step < steps; ++step) {
+            stepNaive(reference, referenceNext, rows, cols);
+            std::swap(reference, referenceNext);
+        }
+        double naiveTime = omp_get_wtime() - startTime;
+
+        startTime = omp_get_wtime();
+        for (int step = 0; step < steps; step += blockSteps) {
+            stepBlocked(u, next, rows, cols, std::min(blockSteps, steps - step));
+            std::swap(u, next);
+        }
+        double blockedTime = omp_get_wtime() - startTime;
+
+        double maxDifference = 0.0;
+        for (size_t k = 0; k < points; ++k) {
+            maxDifference = std::max(maxDifference, std::abs(u[k] - reference[k]));
+        }
+
+        std::cout << "Grid size: " << rows << "x" << cols
+                  << ", Steps: " << steps
+                  << ", Step-by-step time: " << naiveTime << " seconds"
+                  << ", Temporal blocking time: " << blockedTime << " seconds"
+                  << ", Max difference: " << maxDifference << std::endl;
+    }
+}
+
+// Optional positive integer argument argv[index]: fallback when absent, 0
+// when it is not a whole number >= 1.
+int positiveArgument(int argc, char* argv[], int index, int fallback) {
+    if (argc <= index) return fallback;
+    char* end;
+    long value = std::strtol(argv[index], &end, 10);
+    return (*end == '\0' && value >= 1 && value <= INT_MAX) ? static_cast<int>(value) : 0;
+}
+
+int main(int argc, char* argv[]) {
     std::vector<int> gridSizes = {10, 100, 1000, 10000};
-    double dx = 0.01;
+
+    if (argc > 1 && std::string(argv[1]) == "--solve") {
+        int steps = positiveArgument(argc, argv, 2, 100);
+        if (steps == 0) {
+            std::cerr << "Usage: " << argv[0] << " --solve [steps >= 1]" << std::endl;
+            return 1;
+        }
+        solve(steps);
+        return 0;
+    }
+
+    // --perf adds hardware counters and a roofline line to every size.
+    kernels::perf::Machine machine;
+    std::optional<kernels::perf::Counters> counters;
+    if (argc == 2 && std::string(argv[1]) == "--perf") {
+        machine = kernels::perf::measureMachine();
+        kernels::perf::printMachine(std::cout, machine);
+        counters.emplace();
+    }
 
     for (int size : gridSizes) {
         int rows = size;
@@ -45,15 +226,24 @@ int main() {
             }
         }
 
+        if (counters) counters->start();
         double startTime = omp_get_wtime();
 
         computePartialDerivativeX(grid, derivative, dx);
 
         double endTime = omp_get_wtime();
+        if (counters) counters->stop();
 
         std::cout << "Grid size: " << rows << "x" << cols
                   << ", Execution time: " << (endTime - startTime) << " seconds"
                   << std::endl;
+
+        if (counters) {
+            // Per point: one subtraction and one division; read input, write output.
+            double points = static_cast<double>(rows) * cols;
+            kernels::perf::report(std::cout, "Grid size " + std::to_string(size), *counters,
+                                  2 * points, 2 * sizeof(double) * points, machine);
+        }
     }
 
     return 0;
@@ -0,0 +1,355 @@
+#include <mpi.h>
+
+#define CL_TARGET_OPENCL_VERSION 300
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Hybrid MPI + OpenCL matrix multiply. Every rank owns a block of rows of A
+// and C and multiplies it on its node-local OpenCL CPU device with a tiled
+// kernel. B is broadcast from rank 0 in panels of rows; the broadcast of the
+// next panel runs while the device works on the current one, and the kernel
+// accumulates C += A[:, panel] * B[panel, :]. The kernel tile is the largest
+// of tileSizes whose tile x tile work-group the device accepts.
+
+const char* kernelSource = R"CLC(
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#ifndef TILE
+#define TILE 16
+#endif
+
+__kernel void matMulTiled(__global const double* A,
+                          __global const double* B,
+                          __global double* C,
+                          const int rows,
+                          const int n,
+                          const int depth,
+                          const int offset,
+                          const int accumulate) {
+    int row = get_global_id(0);
+    int col = get_global_id(1);
+    int localRow = get_local_id(0);
+    int localCol = get_local_id(1);
+
+    __local double tileA[TILE][TILE];
+    __local double tileB[TILE][TILE];
+
+    double sum = 0.0;
+    for (int t = 0; t < depth; t += TILE) {
+        tileA[localRow][localCol] = (row < rows && t + localCol < depth) ? A[row * n + offset + t + localCol] : 0.0;
+        tileB[localRow][localCol] = (t + localRow < depth && col < n) ? B[(t + localRow) * n + col] : 0.0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (int k = 0; k < TILE; ++k) {
+            sum += tileA[localRow][k] * tileB[k][localCol];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (row < rows && col < n) {
+        C[row * n + col] = accumulate ? C[row * n + col] + sum : sum;
+    }
+}
+)CLC";
+
+// Kernel tiles tried in turn, largest first.
+constexpr int tileSizes[] = {16, 8, 4};
+// Rows of B per broadcast panel; a multiple of every kernel tile.
+constexpr int panelRows = 256;
+// Entries of C recomputed on the host to check the result.
+constexpr int checkedEntries = 64;
+
+void check(cl_int err, const char* msg) {
+    if (err != CL_SUCCESS) {
+        std::cerr << "OpenCL error (" << err << "): " << msg << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+}
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+void generateMatrix(std::vector<double>& mat) {
+    for (double& x : mat) x = rand() % 10;
+}
+
+struct LocalDevice {
+    cl_device_id device = nullptr;
+    bool subDevice = false;
+    cl_uint computeUnits = 0;
+};
+
+// The node's CPU device (any device when there is none). Ranks sharing a node
+// get equal sub-devices of it when the runtime can partition the device, so
+// that they do not all start a thread per core.
+LocalDevice openLocalDevice(int nodeRank, int nodeSize) {
+    LocalDevice local;
+    cl_platform_id platform;
+    check(clGetPlatformIDs(1, &platform, nullptr), "clGetPlatformIDs");
+    if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &local.device, nullptr) != CL_SUCCESS) {
+        check(clGetDeviceIDs(platform, CL_DEVICE_TYPE_DEFAULT, 1, &local.device, nullptr), "clGetDeviceIDs");
+    }
+    clGetDeviceInfo(local.device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(local.computeUnits), &local.computeUnits, nullptr);
+
+    cl_uint unitsPerRank = local.computeUnits / nodeSize;
+    if (nodeSize > 1 && unitsPerRank > 0) {
+        const cl_device_partition_property properties[] = {
+            CL_DEVICE_PARTITION_EQUALLY, static_cast<cl_device_partition_property>(unitsPerRank), 0};
+        cl_uint count = 0;
+        if (clCreateSubDevices(local.device, properties, 0, nullptr, &count) == CL_SUCCESS &&
+            count >= static_cast<cl_uint>(nodeSize)) {
+            std::vector<cl_device_id> subDevices(count);
+            check(clCreateSubDevices(local.device, properties, count, subDevices.data(), nullptr), "clCreateSubDevices");
+            for (cl_uint d = 0; d < count; ++d) {
+                if (d != static_cast<cl_uint>(nodeRank)) clReleaseDevice(subDevices[d]);
+            }
+            local.device = subDevices[nodeRank];
+            local.subDevice = true;
+            local.computeUnits = unitsPerRank;
+        }
+    }
+    return local;
+}
+
+// Builds matMulTiled with TILE = tile for the first of tileSizes whose
+// work-group fits the device. Returns nullptr, and sets tile to 0, when none
+// does.
+cl_kernel buildKernel(cl_context context, cl_device_id device, cl_program& program, int& tile) {
+    cl_int err;
+    for (int candidate : tileSizes) {
+        program = clCreateProgramWithSource(context, 1, &kernelSource, nullptr, &err);
+        check(err, "clCreateProgramWithSource");
+        std::string options = "-DTILE=" + std::to_string(candidate);
+        err = clBuildProgram(program, 1, &device, options.c_str(), nullptr, nullptr);
+        if (err != CL_SUCCESS) {
+            char log[4096];
+            clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, sizeof(log), log, nullptr);
+            std::cerr << "Build error:\n" << log << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        cl_kernel kernel = clCreateKernel(program, "matMulTiled", &err);
+        check(err, "clCreateKernel");
+
+        size_t maxGroup = 0;
+        clGetKernelWorkGroupInfo(kernel, device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(maxGroup), &maxGroup, nullptr);
+        if (maxGroup >= static_cast<size_t>(candidate * candidate)) {
+            tile = candidate;
+            return kernel;
+        }
+        clReleaseKernel(kernel);
+        clReleaseProgram(program);
+    }
+    program = nullptr;
+    tile = 0;
+    return nullptr;
+}
+
+int main(int argc, char* argv[]) {
+    int rank, numProcs;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
+
+    MPI_Comm nodeComm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+    int nodeRank, nodeSize;
+    MPI_Comm_rank(nodeComm, &nodeRank);
+    MPI_Comm_size(nodeComm, &nodeSize);
+
+    LocalDevice local = openLocalDevice(nodeRank, nodeSize);
+    cl_int err;
+    cl_context context = clCreateContext(nullptr, 1, &local.device, nullptr, nullptr, &err);
+    check(err, "clCreateContext");
+    cl_command_queue queue = clCreateCommandQueueWithProperties(context, local.device, nullptr, &err);
+    check(err, "clCreateCommandQueue");
+
+    cl_program program;
+    int tile;
+    cl_kernel kernel = buildKernel(context, local.device, program, tile);
+
+    // Every rank stops together when one of them has no usable tile.
+    int minTile;
+    MPI_Allreduce(&tile, &minTile, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (minTile == 0) {
+        if (tile == 0) {
+            int smallest = tileSizes[std::size(tileSizes) - 1];
+            std::cerr << "Rank " << rank << ": the device cannot run a " << smallest << "x" << smallest
+                      << " work-group." << std::endl;
+        }
+        if (kernel) {
+            clReleaseKernel(kernel);
+            clReleaseProgram(program);
+        }
+        clReleaseCommandQueue(queue);
+        clReleaseContext(context);
+        if (local.subDevice) clReleaseDevice(local.device);
+        MPI_Comm_free(&nodeComm);
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (rank == 0) {
+        std::cout << "Ranks: " << numProcs
+                  << ", Compute units per rank: " << local.computeUnits
+                  << (local.subDevice ? " (sub-device)" : " (whole device)")
+                  << ", Smallest kernel tile: " << minTile << "x" << minTile << std::endl;
+    }
+
+    std::vector<int> sizes = {10, 100, 1000, 2000};
+
+    for (int size : sizes) {
+        // Row blocks of A and C, sizes differing by at most one row.
+        std::vector<int> counts(numProcs), displs(numProcs);
+        for (int proc = 0, offset = 0; proc < numProcs; ++proc) {
+            int procRows = size / numProcs + (proc < size % numProcs ? 1 : 0);
+            counts[proc] = procRows * size;
+            displs[proc] = offset;
+            offset += counts[proc];
+        }
+        int myRows = counts[rank] / size;
+
+        std::vector<double> fullA, fullB, fullC;
+        if (rank == 0) {
+            fullA.resize(static_cast<size_t>(size) * size);
+            fullB.resize(static_cast<size_t>(size) * size);
+            fullC.resize(static_cast<size_t>(size) * size);
+            generateMatrix(fullA);
+            generateMatrix(fullB);
+        }
+
+        int maxPanel = std::min(panelRows, size);
+        size_t blockBytes = std::max<size_t>(counts[rank], 1) * sizeof(double);
+        size_t panelBytes = static_cast<size_t>(maxPanel) * size * sizeof(double);
+        std::vector<double> rowsA(counts[rank]), rowsC(counts[rank]);
+        std::vector<double> panels[2] = {std::vector<double>(static_cast<size_t>(maxPanel) * size),
+                                         std::vector<double>(static_cast<size_t>(maxPanel) * size)};
+
+        cl_mem bufA = clCreateBuffer(context, CL_MEM_READ_ONLY, blockBytes, nullptr, &err);
+        check(err, "clCreateBuffer A");
+        cl_mem bufC = clCreateBuffer(context, CL_MEM_READ_WRITE, blockBytes, nullptr, &err);
+        check(err, "clCreateBuffer C");
+        cl_mem bufB[2];
+        for (int b = 0; b < 2; ++b) {
+            bufB[b] = clCreateBuffer(context, CL_MEM_READ_ONLY, panelBytes, nullptr, &err);
+            check(err, "clCreateBuffer B");
+        }
+        cl_event panelWritten[2] = {nullptr, nullptr};
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        double startTime = MPI_Wtime();
+
+        MPI_Scatterv(fullA.data(), counts.data(), displs.data(), MPI_DOUBLE,
+                     rowsA.data(), counts[rank], MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        if (myRows > 0) {
+            check(clEnqueueWriteBuffer(queue, bufA, CL_FALSE, 0, counts[rank] * sizeof(double), rowsA.data(),
+                                       0, nullptr, nullptr), "write A");
+        }
+
+        int numPanels = (size + maxPanel - 1) / maxPanel;
+        auto panelDepth = [&](int p) { return std::min(maxPanel, size - p * maxPanel); };
+        auto startPanel = [&](int p, MPI_Request* request) {
+            std::vector<double>& panel = panels[p % 2];
+            if (rank == 0) {
+                std::copy(fullB.begin() + static_cast<size_t>(p) * maxPanel * size,
+                          fullB.begin() + static_cast<size_t>(p * maxPanel + panelDepth(p)) * size, panel.begin());
+            }
+            MPI_Ibcast(panel.data(), panelDepth(p) * size, MPI_DOUBLE, 0, MPI_COMM_WORLD, request);
+        };
+
+        MPI_Request request;
+        double waitTime = 0.0;
+        startPanel(0, &request);
+
+        for (int p = 0; p < numPanels; ++p) {
+            double waitStart = MPI_Wtime();
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+            waitTime += MPI_Wtime() - waitStart;
+
+            int current = p % 2;
+            int depth = panelDepth(p);
+            if (panelWritten[current]) clReleaseEvent(panelWritten[current]);
+            check(clEnqueueWriteBuffer(queue, bufB[current], CL_FALSE, 0, static_cast<size_t>(depth) * size * sizeof(double),
+                                       panels[current].data(), 0, nullptr, &panelWritten[current]), "write B panel");
+
+            if (myRows > 0) {
+                int offset = p * maxPanel;
+                int accumulate = p > 0;
+                check(clSetKernelArg(kernel, 0, sizeof(cl_mem), &bufA), "set arg 0");
+                check(clSetKernelArg(kernel, 1, sizeof(cl_mem), &bufB[current]), "set arg 1");
+                check(clSetKernelArg(kernel, 2, sizeof(cl_mem), &bufC), "set arg 2");
+                check(clSetKernelArg(kernel, 3, sizeof(int), &myRows), "set arg 3");
+                check(clSetKernelArg(kernel, 4, sizeof(int), &size), "set arg 4");
+                check(clSetKernelArg(kernel, 5, sizeof(int), &depth), "set arg 5");
+                check(clSetKernelArg(kernel, 6, sizeof(int), &offset), "set arg 6");
+                check(clSetKernelArg(kernel, 7, sizeof(int), &accumulate), "set arg 7");
+
+                size_t globalSize[2] = {roundUp(myRows, tile), roundUp(size, tile)};
+                size_t localSize[2] = {static_cast<size_t>(tile), static_cast<size_t>(tile)};
+                check(clEnqueueNDRangeKernel(queue, kernel, 2, nullptr, globalSize, localSize, 0, nullptr, nullptr),
+                      "enqueue matMulTiled");
+            }
+            check(clFlush(queue), "clFlush");
+
+            // The next panel lands in the host buffer of panel p - 1, whose
+            // write must have finished; the kernel on panel p keeps running.
+            if (p + 1 < numPanels) {
+                int next = (p + 1) % 2;
+                if (panelWritten[next]) check(clWaitForEvents(1, &panelWritten[next]), "wait B panel");
+                startPanel(p + 1, &request);
+            }
+        }
+
+        if (myRows > 0) {
+            check(clEnqueueReadBuffer(queue, bufC, CL_TRUE, 0, counts[rank] * sizeof(double), rowsC.data(),
+                                      0, nullptr, nullptr), "read C");
+        }
+        check(clFinish(queue), "clFinish");
+        MPI_Gatherv(rowsC.data(), counts[rank], MPI_DOUBLE,
+                    fullC.data(), counts.data(), displs.data(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+        double elapsed = MPI_Wtime() - startTime;
+        double maxWait;
+        MPI_Reduce(&waitTime, &maxWait, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+        if (rank == 0) {
+            // Integer-valued inputs keep every sum exact, whatever the order.
+            int mismatches = 0;
+            for (int e = 0; e < checkedEntries; ++e) {
+                int i = rand() % size, j = rand() % size;
+                double expected = 0.0;
+                for (int k = 0; k < size; ++k)
+                    expected += fullA[static_cast<size_t>(i) * size + k] * fullB[static_cast<size_t>(k) * size + j];
+                if (expected != fullC[static_cast<size_t>(i) * size + j]) ++mismatches;
+            }
+
+            std::cout << "Matrix size: " << size << "x" << size
+                      << ", Execution time: " << elapsed << " seconds"
+                      << ", B panels: " << numPanels
+                      << ", Exposed B wait: " << maxWait << " seconds"
+                      << ", Mismatches: " << mismatches << "/" << checkedEntries << std::endl;
+        }
+
+        for (int b = 0; b < 2; ++b) {
+            if (panelWritten[b]) clReleaseEvent(panelWritten[b]);
+            clReleaseMemObject(bufB[b]);
+        }
+        clReleaseMemObject(bufA);
+        clReleaseMemObject(bufC);
+    }
+
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    if (local.subDevice) clReleaseDevice(local.device);
+    MPI_Comm_free(&nodeComm);
+
+    MPI_Finalize();
+    return 0;
+}
@@ -1,6 +1,13 @@
 #include <mpi.h>
+
+#include "kernels/perf.hpp"
+#include "kernels/schedule.hpp"
+
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <vector>
 #include <cstdlib>
 
@@ -25,6 +32,225 @@ void multiplyPartialMatrices(int startRow, int numRows, int size) {
         }
 }
 
+void multiplyRows(const double* rowsA, const double* B, double* rowsC, int numRows, int size) {
+    for (int i = 0; i < numRows; ++i)
+        for (int j = 0; j < size; ++j) {
+            double sum = 0.0;
+            for (int k = 0; k < size; ++k)
+                sum += rowsA[i * size + k] * B[k * size + j];
+            rowsC[i * size + j] = sum;
+        }
+}
+
+// Makes stores to a shared window visible to the other ranks of the node.
+void syncNode(MPI_Win win, MPI_Comm nodeComm) {
+    MPI_Win_sync(win);
+    MPI_Barrier(nodeComm);
+    MPI_Win_sync(win);
+}
+
+// Ranks on the same node share one copy of B (and, with sharedC, of C) in an
+// MPI_Win_allocate_shared window. B crosses the network once per node: rank 0
+// broadcasts it to the node leaders only. Rows are assigned node by node so
+// that every node owns one contiguous block of C.
+void runShared(int rank, int numProcs, bool sharedC, const std::vector<int>& sizes) {
+    MPI_Comm nodeComm, leaderComm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+
+    int nodeRank, nodeSize;
+    MPI_Comm_rank(nodeComm, &nodeRank);
+    MPI_Comm_size(nodeComm, &nodeSize);
+    MPI_Comm_split(MPI_COMM_WORLD, nodeRank == 0 ? 0 : MPI_UNDEFINED, rank, &leaderComm);
+
+    // Node index and the sizes of all nodes, known to every rank.
+    int nodeIndex = 0, numNodes = 0;
+    std::vector<int> nodeSizes;
+    if (nodeRank == 0) {
+        MPI_Comm_rank(leaderComm, &nodeIndex);
+        MPI_Comm_size(leaderComm, &numNodes);
+        nodeSizes.resize(numNodes);
+        MPI_Allgather(&nodeSize, 1, MPI_INT, nodeSizes.data(), 1, MPI_INT, leaderComm);
+    }
+    MPI_Bcast(&nodeIndex, 1, MPI_INT, 0, nodeComm);
+    MPI_Bcast(&numNodes, 1, MPI_INT, 0, nodeComm);
+    nodeSizes.resize(numNodes);
+    MPI_Bcast(nodeSizes.data(), numNodes, MPI_INT, 0, nodeComm);
+
+    int firstWorker = 0;
+    for (int n = 0; n < nodeIndex; ++n) firstWorker += nodeSizes[n];
+    int worker = firstWorker + nodeRank;
+
+    // The node leader owns the memory; the other ranks map it.
+    const MPI_Aint windowBytes = static_cast<MPI_Aint>(N) * N * sizeof(double);
+    double* sharedB;
+    double* sharedCPtr = nullptr;
+    MPI_Win winB, winC = MPI_WIN_NULL;
+    MPI_Win_allocate_shared(nodeRank == 0 ? windowBytes : 0, sizeof(double), MPI_INFO_NULL, nodeComm, &sharedB, &winB);
+    if (sharedC) {
+        MPI_Win_allocate_shared(nodeRank == 0 ? windowBytes : 0, sizeof(double), MPI_INFO_NULL, nodeComm, &sharedCPtr, &winC);
+    }
+    if (nodeRank != 0) {
+        MPI_Aint bytes;
+        int dispUnit;
+        MPI_Win_shared_query(winB, 0, &bytes, &dispUnit, &sharedB);
+        if (sharedC) MPI_Win_shared_query(winC, 0, &bytes, &dispUnit, &sharedCPtr);
+    }
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, winB);
+    if (sharedC) MPI_Win_lock_all(MPI_MODE_NOCHECK, winC);
+
+    for (int size : sizes) {
+        // Row block of every worker, in node-major worker order.
+        std::vector<int> startRows(numProcs), numRows(numProcs);
+        for (int w = 0, row = 0; w < numProcs; ++w) {
+            numRows[w] = size / numProcs + (w < size % numProcs ? 1 : 0);
+            startRows[w] = row;
+            row += numRows[w];
+        }
+        int myStart = startRows[worker], myRows = numRows[worker];
+        int lastWorker = firstWorker + nodeSize - 1;
+        int nodeStart = startRows[firstWorker];
+        int nodeRows = startRows[lastWorker] + numRows[lastWorker] - nodeStart;
+
+        // Scatterv is indexed by world rank, so map each rank to its worker slot.
+        std::vector<int> workerOf(numProcs);
+        MPI_Allgather(&worker, 1, MPI_INT, workerOf.data(), 1, MPI_INT, MPI_COMM_WORLD);
+        std::vector<int> countsA(numProcs), displsA(numProcs);
+        for (int r = 0; r < numProcs; ++r) {
+            countsA[r] = numRows[workerOf[r]] * size;
+            displsA[r] = startRows[workerOf[r]] * size;
+        }
+
+        std::vector<double> fullA, fullC;
+        if (rank == 0) {
+            fullA.resize(static_cast<size_t>(size) * size);
+            for (double& v : fullA) v = rand() % 10;
+            for (int i = 0; i < size * size; ++i) sharedB[i] = rand() % 10;
+            if (!sharedC) fullC.resize(static_cast<size_t>(size) * size);
+        }
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        std::vector<double> localA(static_cast<size_t>(myRows) * size);
+        MPI_Scatterv(fullA.data(), countsA.data(), displsA.data(), MPI_DOUBLE,
+                     localA.data(), myRows * size, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+        if (nodeRank == 0) MPI_Bcast(sharedB, size * size, MPI_DOUBLE, 0, leaderComm);
+        syncNode(winB, nodeComm);
+
+        if (sharedC) {
+            multiplyRows(localA.data(), sharedB, sharedCPtr + static_cast<size_t>(myStart) * size, myRows, size);
+            syncNode(winC, nodeComm);
+
+            // Leaders collect the per-node blocks into rank 0's window.
+            if (nodeRank == 0) {
+                std::vector<int> counts(numNodes), displs(numNodes);
+                for (int n = 0, w = 0; n < numNodes; w += nodeSizes[n], ++n) {
+                    int last = w + nodeSizes[n] - 1;
+                    displs[n] = startRows[w] * size;
+                    counts[n] = (startRows[last] + numRows[last]) * size - displs[n];
+                }
+                double* nodeBlock = sharedCPtr + static_cast<size_t>(nodeStart) * size;
+                MPI_Gatherv(rank == 0 ? MPI_IN_PLACE : nodeBlock, nodeRows * size, MPI_DOUBLE,
+                            sharedCPtr, counts.data(), displs.data(), MPI_DOUBLE, 0, leaderComm);
+            }
+        } else {
+            std::vector<double> localC(static_cast<size_t>(myRows) * size);
+            multiplyRows(localA.data(), sharedB, localC.data(), myRows, size);
+            MPI_Gatherv(localC.data(), myRows * size, MPI_DOUBLE,
+                        fullC.data(), countsA.data(), displsA.data(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        }
+
+        if (rank == 0) {
+            auto endTime = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> duration = endTime - startTime;
+
+            std::cout << "Matrix size: " << size << "x" << size
+                      << ", Nodes: " << numNodes
+                      << ", Shared: " << (sharedC ? "B, C" : "B")
+                      << ", Execution time: " << duration.count() << " s" << std::endl;
+        }
+    }
+
+    if (sharedC) {
+        MPI_Win_unlock_all(winC);
+        MPI_Win_free(&winC);
+    }
+    MPI_Win_unlock_all(winB);
+    MPI_Win_free(&winB);
+    if (leaderComm != MPI_COMM_NULL) MPI_Comm_free(&leaderComm);
+    MPI_Comm_free(&nodeComm);
+}
+
+// ====Dynamic scheduling====
+
+// Rank 0 broadcasts B, then hands out row tiles of A with kernels::schedule
+// and receives the rows of C in place.
+void runDynamic(int rank, int numProcs, const std::vector<int>& sizes) {
+    const int numWorkers = numProcs - 1;
+
+    for (int size : sizes) {
+        // One row of the static matrices: size doubles with a stride of N.
+        MPI_Datatype rowContiguous, rowType;
+        MPI_Type_contiguous(size, MPI_DOUBLE, &rowContiguous);
+        MPI_Type_create_resized(rowContiguous, 0, sizeof(double) * N, &rowType);
+        MPI_Type_commit(&rowType);
+        MPI_Type_free(&rowContiguous);
+
+        if (rank == 0) {
+            generateMatrix(size, size, matrixA);
+            generateMatrix(size, size, matrixB);
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            auto startTime = std::chrono::high_resolution_clock::now();
+
+            MPI_Bcast(&matrixB[0][0], size, rowType, 0, MPI_COMM_WORLD);
+
+            kernels::schedule::Stats stats{1, size};
+            if (numWorkers == 0) {
+                multiplyPartialMatrices(0, size, size);
+            } else {
+                stats = kernels::schedule::distributeTiles(MPI_COMM_WORLD, rowType, &matrixA[0][0], &matrixC[0][0], size);
+            }
+
+            auto endTime = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> duration = endTime - startTime;
+
+            // Time each worker finished its last tile, to show how evenly the work ended.
+            double masterFinish = 0.0;
+            std::vector<double> finish(numProcs);
+            MPI_Gather(&masterFinish, 1, MPI_DOUBLE, finish.data(), 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+            double firstFinish = 0.0, lastFinish = 0.0;
+            if (numWorkers > 0) {
+                firstFinish = *std::min_element(finish.begin() + 1, finish.end());
+                lastFinish = *std::max_element(finish.begin() + 1, finish.end());
+            }
+
+            std::cout << "Matrix size: " << size << "x" << size
+                      << ", Execution time: " << duration.count() << " s"
+                      << ", Tiles: " << stats.tiles
+                      << ", Last tile rows: " << stats.lastTileRows
+                      << ", Worker finish spread: " << lastFinish - firstFinish << " s" << std::endl;
+        } else {
+            std::vector<double> localB(static_cast<size_t>(size) * size);
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            double startTime = MPI_Wtime();
+
+            MPI_Bcast(localB.data(), size * size, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+            kernels::schedule::workTiles(MPI_COMM_WORLD, size, size, [&](const double* rowsA, double* rowsC, int numRows) {
+                multiplyRows(rowsA, localB.data(), rowsC, numRows, size);
+            });
+
+            double finish = MPI_Wtime() - startTime;
+            MPI_Gather(&finish, 1, MPI_DOUBLE, nullptr, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        }
+
+        MPI_Type_free(&rowType);
+    }
+}
+
 int main(int argc, char** argv) {
     int rank, numProcs, index, elementsPerProc;
 
@@ -34,6 +260,27 @@ int main(int argc, char** argv) {
 
     std::vector<int> sizes = {10, 100, 1000, 2000};
 
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--shared" || mode == "--shared-c") {
+        runShared(rank, numProcs, mode == "--shared-c", sizes);
+        MPI_Finalize();
+        return 0;
+    }
+    if (mode == "--dynamic") {
+        runDynamic(rank, numProcs, sizes);
+        MPI_Finalize();
+        return 0;
+    }
+
+    // --perf adds per-rank hardware counters and a roofline line to every size.
+    kernels::perf::Machine machine;
+    std::optional<kernels::perf::Counters> counters;
+    if (mode == "--perf") {
+        machine = kernels::perf::measureMachine(MPI_COMM_WORLD);
+        if (rank == 0) kernels::perf::printMachine(std::cout, machine);
+        counters.emplace();
+    }
+
     for (int size : sizes) {
         if (rank == 0) {
             generateMatrix(size, size, matrixA);
@@ -43,6 +290,7 @@ int main(int argc, char** argv) {
                 for (int j = 0; j < size; ++j)
                     matrixC[i][j] = 0.0;
 
+            if (counters) counters->start();
             auto startTime = std::chrono::high_resolution_clock::now();
 
             elementsPerProc = size / numProcs;
@@ -72,11 +320,13 @@ int main(int argc, char** argv) {
             }
 
             auto endTime = std::chrono::high_resolution_clock::now();
+            if (counters) counters->stop();
             std::chrono::duration<double> duration = endTime - startTime;
 
             std::cout << "Matrix size: " << size << "x" << size
                       << ", Execution time: " << duration.count() << " s" << std::endl;
         } else {
+            if (counters) counters->start();
             int startRow, numRows;
             MPI_Recv(&startRow, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
             MPI_Recv(&numRows, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
@@ -88,6 +338,13 @@ int main(int argc, char** argv) {
             MPI_Send(&startRow, 1, MPI_INT, 0, 1, MPI_COMM_WORLD);
             MPI_Send(&numRows, 1, MPI_INT, 0, 1, MPI_COMM_WORLD);
             MPI_Send(&matrixC[startRow][0], numRows * size, MPI_DOUBLE, 0, 1, MPI_COMM_WORLD);
+            if (counters) counters->stop();
+        }
+
+        if (counters) {
+            double n = size;
+            kernels::perf::report(std::cout, "Matrix size " + std::to_string(size), *counters,
+                                  2 * n * n * n, 3 * sizeof(double) * n * n, machine, MPI_COMM_WORLD);
         }
     }
 
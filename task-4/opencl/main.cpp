@@ -1,9 +1,11 @@
 #define CL_TARGET_OPENCL_VERSION 300
 #include <CL/cl.h>
+#include "kernels/numa.hpp"
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <cstdlib>
+#include <string>
 
 const char* kernelSource = R"CLC(
 __kernel void matMul(
@@ -29,7 +31,81 @@ void generateMatrix(std::vector<float>& mat, int size) {
         mat[i] = static_cast<float>(rand() % 10);
 }
 
-int main() {
+// --numa: the rows of A and C are split into one contiguous block per NUMA
+// sub-device of the CPU device; each sub-device gets its own queue, its block
+// of A and C and a local copy of B.
+void multiplyNuma(cl_platform_id platform, const std::vector<int>& sizes) {
+    kernels::numa::Devices devices = kernels::numa::create(platform);
+    kernels::numa::printDevices(std::cout, devices);
+
+    cl_int err;
+    cl_program program = kernels::numa::build(devices, kernelSource);
+    cl_kernel kernel = clCreateKernel(program, "matMul", &err);
+    kernels::numa::check(err, "clCreateKernel");
+
+    const int parts = devices.count();
+
+    for (int size : sizes) {
+        size_t bytes = size * size * sizeof(float);
+        std::vector<float> A(size * size);
+        std::vector<float> B(size * size);
+        std::vector<float> C(size * size, 0);
+
+        generateMatrix(A, size);
+        generateMatrix(B, size);
+
+        std::vector<kernels::numa::Range> ranges(parts);
+        std::vector<cl_mem> bufA(parts, nullptr), bufB(parts, nullptr), bufC(parts, nullptr);
+        for (int p = 0; p < parts; ++p) {
+            ranges[p] = kernels::numa::range(size, parts, p);
+            if (ranges[p].size() == 0) continue;
+            size_t blockBytes = ranges[p].size() * size * sizeof(float);
+            bufA[p] = kernels::numa::localBuffer(devices, p, CL_MEM_READ_ONLY, blockBytes,
+                                                 A.data() + ranges[p].begin * size);
+            bufB[p] = kernels::numa::localBuffer(devices, p, CL_MEM_READ_ONLY, bytes, B.data());
+            bufC[p] = kernels::numa::localBuffer(devices, p, CL_MEM_WRITE_ONLY, blockBytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int p = 0; p < parts; ++p) {
+            if (ranges[p].size() == 0) continue;
+            clSetKernelArg(kernel, 0, sizeof(cl_mem), &bufA[p]);
+            clSetKernelArg(kernel, 1, sizeof(cl_mem), &bufB[p]);
+            clSetKernelArg(kernel, 2, sizeof(cl_mem), &bufC[p]);
+            clSetKernelArg(kernel, 3, sizeof(int), &size);
+
+            size_t globalSize[2] = {static_cast<size_t>(ranges[p].size()), static_cast<size_t>(size)};
+            err = clEnqueueNDRangeKernel(devices.queues[p], kernel, 2, nullptr, globalSize, nullptr, 0, nullptr, nullptr);
+            kernels::numa::check(err, "enqueue matMul");
+            clFlush(devices.queues[p]);
+        }
+
+        for (int p = 0; p < parts; ++p) {
+            if (ranges[p].size() == 0) continue;
+            err = clEnqueueReadBuffer(devices.queues[p], bufC[p], CL_TRUE, 0, ranges[p].size() * size * sizeof(float),
+                                      C.data() + ranges[p].begin * size, 0, nullptr, nullptr);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = end - start;
+
+        std::cout << "Matrix size: " << size << "x" << size
+                  << ", Execution time: " << elapsed.count() << " seconds" << std::endl;
+
+        for (int p = 0; p < parts; ++p) {
+            if (bufA[p]) clReleaseMemObject(bufA[p]);
+            if (bufB[p]) clReleaseMemObject(bufB[p]);
+            if (bufC[p]) clReleaseMemObject(bufC[p]);
+        }
+    }
+
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+    kernels::numa::release(devices);
+}
+
+int main(int argc, char* argv[]) {
     std::vector<int> sizes = {10, 100, 1000, 2000};
 
     cl_platform_id platform;
@@ -41,6 +117,12 @@ int main() {
     cl_int err;
 
     err = clGetPlatformIDs(1, &platform, nullptr);
+
+    if (argc == 2 && std::string(argv[1]) == "--numa") {
+        multiplyNuma(platform, sizes);
+        return 0;
+    }
+
     err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &device, nullptr);
     context = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &err);
     queue = clCreateCommandQueueWithProperties(context, device, 0, &err);
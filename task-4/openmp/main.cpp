@@ -1,7 +1,11 @@
+#include "kernels/perf.hpp"
+
 #include <omp.h>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <vector>
 
 std::vector<std::vector<int>> generateMatrix(int rows, int cols) {
@@ -41,10 +45,19 @@ std::vector<std::vector<int>> multiplyMatrices(
     return result;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     std::vector<std::pair<int, int>> matrixSizes = {
         {10, 10}, {100, 100}, {1000, 1000}, {2000, 2000}};
 
+    // --perf adds hardware counters and a roofline line to every size.
+    kernels::perf::Machine machine;
+    std::optional<kernels::perf::Counters> counters;
+    if (argc == 2 && std::string(argv[1]) == "--perf") {
+        machine = kernels::perf::measureMachine();
+        kernels::perf::printMachine(std::cout, machine);
+        counters.emplace();
+    }
+
     for (const auto& size : matrixSizes) {
         int rowsA = size.first;
         int colsA = size.second;
@@ -54,14 +67,25 @@ int main() {
         std::vector<std::vector<int>> matrixA = generateMatrix(rowsA, colsA);
         std::vector<std::vector<int>> matrixB = generateMatrix(rowsB, colsB);
 
+        if (counters) counters->start();
         double startTime = omp_get_wtime();
         std::vector<std::vector<int>> result = multiplyMatrices(matrixA, matrixB);
         double endTime = omp_get_wtime();
+        if (counters) counters->stop();
 
         std::cout << "Matrix sizes: " << rowsA << "x" << colsA << " * "
                   << rowsB << "x" << colsB
                   << ", Execution time: " << (endTime - startTime)
                   << " s" << std::endl;
+
+        if (counters) {
+            // Integer multiply-adds, counted against the floating-point peak.
+            double flops = 2.0 * rowsA * colsB * colsA;
+            double bytes = sizeof(int) * (static_cast<double>(rowsA) * colsA + static_cast<double>(rowsB) * colsB +
+                                          static_cast<double>(rowsA) * colsB);
+            kernels::perf::report(std::cout, "Matrix size " + std::to_string(rowsA), *counters, flops, bytes,
+                                  machine);
+        }
     }
 
     return 0;